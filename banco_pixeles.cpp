@@ -0,0 +1,276 @@
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "conversion_pixeles.h"
+
+// Banco de pruebas del pipeline de píxeles, sin servidor X ni GL.
+// Arma XImages sintéticas en memoria (XInitImage) con distintas profundidades,
+// órdenes de bytes y máscaras, compara la conversión contra la implementación
+// de referencia (XGetPixel pixel a pixel) y mide cada kernel en ns/pixel y GB/s.
+//
+// Uso: banco_pixeles [--json archivo] [--reps N] [--hilos N]
+// Sale con código 1 si algún resultado no coincide con la referencia.
+
+struct Format {
+    const char* name;
+    int depth, bpp, byteOrder;
+    unsigned long rmask, gmask, bmask;
+};
+
+static const Format FORMATS[] = {
+    { "24/32 lsb rgb", 24, 32, LSBFirst, 0xff0000, 0x00ff00, 0x0000ff },
+    { "24/32 msb rgb", 24, 32, MSBFirst, 0xff0000, 0x00ff00, 0x0000ff },
+    { "24/32 lsb bgr", 24, 32, LSBFirst, 0x0000ff, 0x00ff00, 0xff0000 },
+    { "32/32 msb bgr", 32, 32, MSBFirst, 0x0000ff, 0x00ff00, 0xff0000 },
+    { "24/24 lsb rgb", 24, 24, LSBFirst, 0xff0000, 0x00ff00, 0x0000ff },
+    { "24/24 msb rgb", 24, 24, MSBFirst, 0xff0000, 0x00ff00, 0x0000ff },
+    { "16/16 lsb 565", 16, 16, LSBFirst, 0xf800, 0x07e0, 0x001f },
+    { "16/16 msb 565", 16, 16, MSBFirst, 0xf800, 0x07e0, 0x001f },
+    { "15/16 lsb 555", 15, 16, LSBFirst, 0x7c00, 0x03e0, 0x001f },
+};
+
+// Imagen sintética: el XImage apunta a 'data', que le pertenece a esta estructura.
+struct SyntheticImage {
+    XImage img;
+    std::vector<char> data;
+};
+
+static bool make_image(SyntheticImage &s, const Format &f, int width, int height, unsigned seed) {
+    memset(&s.img, 0, sizeof(s.img));
+    // filas con relleno extra para no depender de bytes_per_line == width * bpp / 8
+    int rowBytes = ((width * f.bpp + 31) / 32) * 4 + 8;
+    s.data.resize((size_t)rowBytes * height);
+    srand(seed);
+    for (size_t i = 0; i < s.data.size(); ++i) s.data[i] = (char)(rand() & 0xff);
+
+    XImage &img = s.img;
+    img.width = width;
+    img.height = height;
+    img.xoffset = 0;
+    img.format = ZPixmap;
+    img.data = s.data.data();
+    img.byte_order = f.byteOrder;
+    img.bitmap_unit = 32;
+    img.bitmap_bit_order = f.byteOrder;
+    img.bitmap_pad = 32;
+    img.depth = f.depth;
+    img.bytes_per_line = rowBytes;
+    img.bits_per_pixel = f.bpp;
+    img.red_mask = f.rmask;
+    img.green_mask = f.gmask;
+    img.blue_mask = f.bmask;
+    return XInitImage(&img) != 0;
+}
+
+// ---------------- Referencia ----------------
+// Misma conversión que el ensure_texture() original, pixel a pixel.
+static void reference_convert(XImage* img, unsigned char* pixels) {
+    int width = img->width, height = img->height;
+    unsigned long rmask = img->red_mask;
+    unsigned long gmask = img->green_mask;
+    unsigned long bmask = img->blue_mask;
+    int rshift = 0; while (!((rmask >> rshift) & 1) && rshift < 32) rshift++;
+    int gshift = 0; while (!((gmask >> gshift) & 1) && gshift < 32) gshift++;
+    int bshift = 0; while (!((bmask >> bshift) & 1) && bshift < 32) bshift++;
+
+    for (int y = 0; y < height; ++y) {
+        int ty = height - 1 - y;
+        for (int x = 0; x < width; ++x) {
+            unsigned long p = XGetPixel(img, x, y);
+            size_t idx = ((size_t)ty * width + x) * 3;
+            pixels[idx]     = ((p & rmask) >> rshift) & 0xFF;
+            pixels[idx + 1] = ((p & gmask) >> gshift) & 0xFF;
+            pixels[idx + 2] = ((p & bmask) >> bshift) & 0xFF;
+        }
+    }
+}
+
+static void reference_downscale(const unsigned char* src, int sw, int sh,
+                                unsigned char* dst, int dw, int dh) {
+    for (int dy = 0; dy < dh; ++dy) {
+        for (int dx = 0; dx < dw; ++dx) {
+            int y0 = (int)((long)dy * sh / dh), y1 = (int)((long)(dy + 1) * sh / dh);
+            int x0 = (int)((long)dx * sw / dw), x1 = (int)((long)(dx + 1) * sw / dw);
+            if (y1 <= y0) y1 = y0 + 1;
+            if (x1 <= x0) x1 = x0 + 1;
+            for (int c = 0; c < 3; ++c) {
+                unsigned int sum = 0, n = 0;
+                for (int y = y0; y < y1; ++y)
+                    for (int x = x0; x < x1; ++x, ++n)
+                        sum += src[((size_t)y * sw + x) * 3 + c];
+                dst[((size_t)dy * dw + dx) * 3 + c] = (sum + n / 2) / n;
+            }
+        }
+    }
+}
+
+// ---------------- Correctitud ----------------
+static int g_checks = 0, g_failures = 0;
+
+static void check(bool ok, const char* what, const char* format, int w, int h) {
+    ++g_checks;
+    if (!ok) {
+        ++g_failures;
+        fprintf(stderr, "FALLA: %s [%s] %dx%d\n", what, format, w, h);
+    }
+}
+
+static void run_correctness(ThreadPool* pool) {
+    // tamaños chicos, impares y uno que supera el umbral de varios hilos
+    const int SIZES[][2] = { { 1, 1 }, { 7, 3 }, { 333, 77 }, { 640, 480 }, { 1031, 517 } };
+
+    for (const Format &f : FORMATS) {
+        for (auto &sz : SIZES) {
+            int w = sz[0], h = sz[1];
+            SyntheticImage s;
+            if (!make_image(s, f, w, h, w * 31 + h)) {
+                check(false, "XInitImage", f.name, w, h);
+                continue;
+            }
+            size_t bytes = (size_t)w * h * 3;
+            std::vector<unsigned char> ref(bytes), out(bytes);
+            reference_convert(&s.img, ref.data());
+
+            convert_image_rgb(&s.img, out.data(), nullptr);
+            check(out == ref, "conversión 1 hilo", f.name, w, h);
+
+            std::fill(out.begin(), out.end(), 0);
+            convert_image_rgb(&s.img, out.data(), pool);
+            check(out == ref, "conversión por bandas", f.name, w, h);
+
+            // copia directa de la vista principal: mismos colores en orden B, G, R
+            if (image_is_native_bgra(&s.img)) {
+                std::vector<unsigned char> bgra((size_t)w * h * 4);
+                copy_rows_bgra(&s.img, bgra.data());
+                bool same = true;
+                for (size_t i = 0; i < (size_t)w * h && same; ++i)
+                    same = bgra[i * 4] == ref[i * 3 + 2] && bgra[i * 4 + 1] == ref[i * 3 + 1] &&
+                           bgra[i * 4 + 2] == ref[i * 3];
+                check(same, "copia BGRA", f.name, w, h);
+            }
+        }
+    }
+
+    // reducción: contra la versión ingenua, con factores enteros y no enteros
+    const int SCALES[][4] = { { 640, 480, 160, 120 }, { 1031, 517, 97, 61 }, { 333, 77, 333, 77 }, { 5, 5, 1, 1 } };
+    for (auto &sc : SCALES) {
+        std::vector<unsigned char> src((size_t)sc[0] * sc[1] * 3);
+        for (size_t i = 0; i < src.size(); ++i) src[i] = (unsigned char)(rand() & 0xff);
+        std::vector<unsigned char> ref((size_t)sc[2] * sc[3] * 3), out(ref.size());
+        reference_downscale(src.data(), sc[0], sc[1], ref.data(), sc[2], sc[3]);
+        downscale_box_rgb(src.data(), sc[0], sc[1], out.data(), sc[2], sc[3]);
+        check(out == ref, "reducción", "rgb", sc[2], sc[3]);
+    }
+}
+
+// ---------------- Benchmarks ----------------
+struct Result {
+    std::string kernel, format;
+    int width, height, threads;
+    double nsPerPixel, gbPerSec;
+};
+
+static std::vector<Result> g_results;
+
+// Mide 'fn' y registra ns por pixel de origen y GB/s de bytes leídos + escritos.
+template <typename Fn>
+static void bench(const char* kernel, const char* format, int w, int h, int threads,
+                  size_t bytesMoved, int reps, Fn fn) {
+    fn(); // calentamiento
+    double t0 = seconds_now();
+    for (int r = 0; r < reps; ++r) fn();
+    double secs = (seconds_now() - t0) / reps;
+
+    Result res = { kernel, format, w, h, threads, secs * 1e9 / ((double)w * h), bytesMoved / secs / 1e9 };
+    printf("%-22s %-14s %5dx%-5d %2d hilos  %7.3f ns/px  %7.2f GB/s\n", kernel, format, w, h,
+           threads, res.nsPerPixel, res.gbPerSec);
+    g_results.push_back(res);
+}
+
+static void run_benchmarks(int reps, int maxThreads) {
+    const int W = 1920, H = 1080;
+    UploadBuffer buf;
+    unsigned char* dst = buf.reserve((size_t)W * H * 3);
+
+    for (const Format &f : FORMATS) {
+        SyntheticImage s;
+        if (!make_image(s, f, W, H, 1)) continue;
+        size_t moved = (size_t)s.img.bytes_per_line * H + (size_t)W * H * 3;
+
+        // la conversión de producción voltea las filas en la misma pasada (ty = height - 1 - y)
+        bench("referencia", f.name, W, H, 1, moved, reps, [&] { reference_convert(&s.img, dst); });
+        bench("conversion_flip", f.name, W, H, 1, moved, reps, [&] { convert_image_rgb(&s.img, dst, nullptr); });
+        // potencias de dos y siempre el total de núcleos como último punto (6, 12, ...)
+        for (int t = 2; t <= maxThreads; t = t < maxThreads && t * 2 > maxThreads ? maxThreads : t * 2) {
+            ThreadPool pool(t);
+            bench("conversion_flip_bandas", f.name, W, H, t, moved, reps, [&] { convert_image_rgb(&s.img, dst, &pool); });
+        }
+        if (image_is_native_bgra(&s.img)) {
+            std::vector<unsigned char> bgra((size_t)W * H * 4);
+            bench("copia_bgra", f.name, W, H, 1, (size_t)s.img.bytes_per_line * H + bgra.size(), reps,
+                  [&] { copy_rows_bgra(&s.img, bgra.data()); });
+        }
+    }
+
+    std::vector<unsigned char> rgb((size_t)W * H * 3, 0x80);
+    const int DW[] = { W / 2, W / 8, 160 };
+    for (int dw : DW) {
+        int dh = (int)((long)dw * H / W);
+        std::vector<unsigned char> small((size_t)dw * dh * 3);
+        char name[32];
+        snprintf(name, sizeof(name), "reduccion_%dx%d", dw, dh);
+        bench(name, "rgb", W, H, 1, rgb.size() + small.size(), reps,
+              [&] { downscale_box_rgb(rgb.data(), W, H, small.data(), dw, dh); });
+    }
+}
+
+static bool write_json(const char* path) {
+    FILE* f = strcmp(path, "-") ? fopen(path, "w") : stdout;
+    if (!f) return false;
+    fprintf(f, "{\n  \"correctness\": {\"checks\": %d, \"failures\": %d},\n  \"results\": [\n",
+            g_checks, g_failures);
+    for (size_t i = 0; i < g_results.size(); ++i) {
+        const Result &r = g_results[i];
+        fprintf(f, "    {\"kernel\": \"%s\", \"format\": \"%s\", \"width\": %d, \"height\": %d, "
+                   "\"threads\": %d, \"ns_per_pixel\": %.4f, \"gb_per_s\": %.4f}%s\n",
+                r.kernel.c_str(), r.format.c_str(), r.width, r.height, r.threads,
+                r.nsPerPixel, r.gbPerSec, i + 1 < g_results.size() ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    if (f != stdout) fclose(f);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    const char* jsonPath = nullptr;
+    int reps = 10;
+    int threads = default_thread_count();
+
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--json") && i + 1 < argc) jsonPath = argv[++i];
+        else if (!strcmp(argv[i], "--reps") && i + 1 < argc) reps = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--hilos") && i + 1 < argc) threads = atoi(argv[++i]);
+        else {
+            fprintf(stderr, "Uso: %s [--json archivo] [--reps N] [--hilos N]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (reps < 1) reps = 1;
+    if (threads < 2) threads = 2; // para ejercitar el reparto en bandas aunque haya un núcleo
+
+    ThreadPool pool(threads);
+    run_correctness(&pool);
+    printf("Correctitud: %d comprobaciones, %d fallas\n", g_checks, g_failures);
+
+    run_benchmarks(reps, threads);
+
+    if (jsonPath && !write_json(jsonPath)) {
+        fprintf(stderr, "No se pudo escribir %s\n", jsonPath);
+        return 2;
+    }
+    return g_failures ? 1 : 0;
+}
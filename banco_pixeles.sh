@@ -0,0 +1,8 @@
+#!/bin/sh
+
+n=banco_pixeles
+rm ./$n
+g++ -O2 $n.cpp -o $n -pthread -lX11
+if [[ -f ./$n ]];then
+	./$n --json $n.json
+fi
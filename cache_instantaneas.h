@@ -0,0 +1,265 @@
+#ifndef CACHE_INSTANTANEAS_H
+#define CACHE_INSTANTANEAS_H
+
+// Caché de instantáneas comprimidas en RAM: guarda el último frame RGB de cada
+// ventana que deja de estar seleccionada, para mostrarlo al volver a ella mientras
+// llega la captura en vivo. El códec es del estilo QOI: sin pérdida, una sola
+// pasada, muy rápido y con buena compresión en contenido de escritorio.
+
+#include <X11/Xlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include <map>
+#include <deque>
+#include <utility>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+// ---------------- Códec ----------------
+enum {
+    SNAP_OP_INDEX = 0x00, // 00xxxxxx: color visto recientemente
+    SNAP_OP_DIFF  = 0x40, // 01rrggbb: diferencia chica con el píxel anterior
+    SNAP_OP_LUMA  = 0x80, // 10gggggg rrrrbbbb: diferencia guiada por el verde
+    SNAP_OP_RUN   = 0xC0, // 11xxxxxx: repetición del píxel anterior (1..62)
+    SNAP_OP_RGB   = 0xFE  // 11111110 r g b
+};
+
+static inline int snapshot_hash(unsigned char r, unsigned char g, unsigned char b) {
+    return (r * 3 + g * 5 + b * 7) & 63;
+}
+
+// Comprime 'npixels' píxeles RGB; devuelve los bytes comprimidos.
+static inline std::vector<unsigned char> snapshot_compress(const unsigned char* rgb, size_t npixels) {
+    std::vector<unsigned char> out;
+    out.resize(npixels * 4 + 16);
+    unsigned char* o = out.data();
+
+    unsigned char index[64][3];
+    memset(index, 0, sizeof(index));
+    unsigned char pr = 0, pg = 0, pb = 0;
+    int run = 0;
+
+    for (size_t i = 0; i < npixels; ++i) {
+        unsigned char r = rgb[i * 3], g = rgb[i * 3 + 1], b = rgb[i * 3 + 2];
+
+        if (r == pr && g == pg && b == pb) {
+            if (++run == 62) { *o++ = SNAP_OP_RUN | (run - 1); run = 0; }
+            continue;
+        }
+        if (run) { *o++ = SNAP_OP_RUN | (run - 1); run = 0; }
+
+        int h = snapshot_hash(r, g, b);
+        if (index[h][0] == r && index[h][1] == g && index[h][2] == b) {
+            *o++ = SNAP_OP_INDEX | h;
+        } else {
+            index[h][0] = r; index[h][1] = g; index[h][2] = b;
+            signed char dr = (signed char)(r - pr);
+            signed char dg = (signed char)(g - pg);
+            signed char db = (signed char)(b - pb);
+            signed char dr_dg = dr - dg, db_dg = db - dg;
+            if (dr > -3 && dr < 2 && dg > -3 && dg < 2 && db > -3 && db < 2) {
+                *o++ = SNAP_OP_DIFF | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2);
+            } else if (dg > -33 && dg < 32 && dr_dg > -9 && dr_dg < 8 && db_dg > -9 && db_dg < 8) {
+                *o++ = SNAP_OP_LUMA | (dg + 32);
+                *o++ = (dr_dg + 8) << 4 | (db_dg + 8);
+            } else {
+                *o++ = SNAP_OP_RGB;
+                *o++ = r; *o++ = g; *o++ = b;
+            }
+        }
+        pr = r; pg = g; pb = b;
+    }
+    if (run) *o++ = SNAP_OP_RUN | (run - 1);
+
+    out.resize(o - out.data());
+    out.shrink_to_fit();
+    return out;
+}
+
+static inline bool snapshot_decompress(const std::vector<unsigned char>& in, unsigned char* rgb, size_t npixels) {
+    const unsigned char* p = in.data();
+    const unsigned char* end = p + in.size();
+    unsigned char index[64][3];
+    memset(index, 0, sizeof(index));
+    unsigned char r = 0, g = 0, b = 0;
+    size_t i = 0;
+
+    while (i < npixels && p < end) {
+        unsigned char op = *p++;
+        if (op == SNAP_OP_RGB) {
+            if (end - p < 3) return false;
+            r = p[0]; g = p[1]; b = p[2];
+            p += 3;
+        } else if ((op & 0xC0) == SNAP_OP_RUN) {
+            int run = (op & 0x3F) + 1;
+            for (int k = 0; k < run && i < npixels; ++k, ++i) {
+                rgb[i * 3] = r; rgb[i * 3 + 1] = g; rgb[i * 3 + 2] = b;
+            }
+            continue;
+        } else if ((op & 0xC0) == SNAP_OP_INDEX) {
+            r = index[op][0]; g = index[op][1]; b = index[op][2];
+        } else if ((op & 0xC0) == SNAP_OP_DIFF) {
+            r += ((op >> 4) & 3) - 2;
+            g += ((op >> 2) & 3) - 2;
+            b += (op & 3) - 2;
+        } else { // SNAP_OP_LUMA
+            if (p >= end) return false;
+            int dg = (op & 0x3F) - 32;
+            unsigned char q = *p++;
+            r += dg + ((q >> 4) & 0x0F) - 8;
+            g += dg;
+            b += dg + (q & 0x0F) - 8;
+        }
+        int h = snapshot_hash(r, g, b);
+        index[h][0] = r; index[h][1] = g; index[h][2] = b;
+        rgb[i * 3] = r; rgb[i * 3 + 1] = g; rgb[i * 3 + 2] = b;
+        ++i;
+    }
+    return i == npixels;
+}
+
+// ---------------- Caché con presupuesto de memoria ----------------
+struct Snapshot {
+    int width, height;
+    std::vector<unsigned char> data;
+    unsigned long lastUse;
+};
+
+class SnapshotCache {
+public:
+    explicit SnapshotCache(size_t budgetBytes) : budget(budgetBytes) {}
+
+    // Guarda (o reemplaza) el frame de 'w'; expulsa las menos usadas si no entra.
+    void put(Window w, const unsigned char* rgb, int width, int height) {
+        store(w, width, height, snapshot_compress(rgb, (size_t)width * height));
+    }
+
+    // Igual que put() con el frame ya comprimido (p. ej. en otro hilo).
+    void store(Window w, int width, int height, std::vector<unsigned char> data) {
+        erase(w);
+        Snapshot s;
+        s.width = width;
+        s.height = height;
+        s.data = std::move(data);
+        s.lastUse = ++clock;
+        if (s.data.size() > budget) return;
+        used += s.data.size();
+        entries[w] = std::move(s);
+        while (used > budget) evict_oldest();
+    }
+
+    const Snapshot* find(Window w) {
+        auto it = entries.find(w);
+        if (it == entries.end()) return nullptr;
+        it->second.lastUse = ++clock;
+        return &it->second;
+    }
+
+    void erase(Window w) {
+        auto it = entries.find(w);
+        if (it == entries.end()) return;
+        used -= it->second.data.size();
+        entries.erase(it);
+    }
+
+    size_t bytes_used() const { return used; }
+    size_t count() const { return entries.size(); }
+
+private:
+    void evict_oldest() {
+        auto oldest = entries.begin();
+        for (auto it = entries.begin(); it != entries.end(); ++it)
+            if (it->second.lastUse < oldest->second.lastUse) oldest = it;
+        used -= oldest->second.data.size();
+        entries.erase(oldest);
+    }
+
+    size_t budget;
+    size_t used = 0;
+    unsigned long clock = 0;
+    std::map<Window, Snapshot> entries;
+};
+
+// ---------------- Compresión en segundo plano ----------------
+// Comprime en un hilo aparte y guarda en la caché, así el hilo de GL no pierde un
+// cuadro por cada cambio. Mientras exista el compresor, la caché solo se toca con
+// 'lock' tomado, y sin tenerlo tomado al llamar a queue() o forget().
+// Se crea con new y no se destruye: el hilo queda vivo hasta que termina el proceso.
+class SnapshotCompressor {
+public:
+    std::mutex lock;
+
+    explicit SnapshotCompressor(SnapshotCache* c) : cache(c) {
+        std::thread(&SnapshotCompressor::run, this).detach();
+    }
+
+    // Encola el frame RGB de 'w'; se lo lleva y deja 'frame' vacío.
+    void queue(Window w, int width, int height, std::vector<unsigned char> &frame) {
+        std::lock_guard<std::mutex> q(jobsMutex);
+        for (auto it = jobs.begin(); it != jobs.end(); ++it)
+            if (it->window == w) { jobs.erase(it); break; }
+        if (jobs.size() >= MAX_JOBS) jobs.pop_front(); // cambios muy seguidos: se descartan los más viejos
+        jobs.push_back({ w, width, height, std::move(frame) });
+        frame.clear();
+        ready.notify_one();
+    }
+
+    // Igual, copiando el frame (para buffers que se reutilizan).
+    void queue(Window w, const unsigned char* rgb, int width, int height) {
+        std::vector<unsigned char> frame(rgb, rgb + (size_t)width * height * 3);
+        queue(w, width, height, frame);
+    }
+
+    // Ventana destruida: descarta lo pendiente y su instantánea.
+    void forget(Window w) {
+        {
+            std::lock_guard<std::mutex> q(jobsMutex);
+            for (auto it = jobs.begin(); it != jobs.end(); )
+                it = it->window == w ? jobs.erase(it) : it + 1;
+            if (busy == w) busyCancelled = true;
+        }
+        std::lock_guard<std::mutex> c(lock);
+        cache->erase(w);
+    }
+
+private:
+    struct Job {
+        Window window;
+        int width, height;
+        std::vector<unsigned char> frame;
+    };
+    static const size_t MAX_JOBS = 4;
+
+    void run() {
+        for (;;) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> q(jobsMutex);
+                ready.wait(q, [this] { return !jobs.empty(); });
+                job = std::move(jobs.front());
+                jobs.pop_front();
+                busy = job.window;
+                busyCancelled = false;
+            }
+            std::vector<unsigned char> data =
+                snapshot_compress(job.frame.data(), (size_t)job.width * job.height);
+            std::lock_guard<std::mutex> q(jobsMutex);
+            if (!busyCancelled) {
+                std::lock_guard<std::mutex> c(lock);
+                cache->store(job.window, job.width, job.height, std::move(data));
+            }
+            busy = 0;
+        }
+    }
+
+    SnapshotCache* cache;
+    std::mutex jobsMutex;
+    std::condition_variable ready;
+    std::deque<Job> jobs;
+    Window busy = 0;            // ventana que se está comprimiendo
+    bool busyCancelled = false; // se destruyó mientras tanto: no guardarla
+};
+
+#endif
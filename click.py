@@ -5,11 +5,26 @@ import random
 import time
 import sys
 
+import demonio_click
+
+# Conexión al demonio de automatización (demonio_click), si está corriendo.
+# Sin demonio, cada acción lanza wmctrl/xdotool como subprocesos.
+_demonio = None
+# Última geometría conocida de cada ventana (solo con demonio): las coordenadas
+# de una acción salen de la geometría leída en el lote de la acción anterior.
+_geometrias = {}
+
 def get_windows():
     """
     Obtiene una lista de ventanas disponibles usando wmctrl.
     Retorna una lista de tuplas (ID de ventana, Título de ventana).
     """
+    if _demonio:
+        try:
+            return _demonio.list_windows()
+        except demonio_click.ErrorDemonio as e:
+            print(f"Error del demonio al listar ventanas: {e}")
+            return []
     try:
         output = subprocess.check_output(["wmctrl", "-l"]).decode("utf-8")
         windows = []
@@ -36,6 +51,12 @@ def get_window_geometry(window_id):
     Obtiene las dimensiones (ancho, alto) y la posición (x, y) de una ventana específica usando xdotool.
     Retorna un diccionario con 'WIDTH', 'HEIGHT', 'X', 'Y'.
     """
+    if _demonio:
+        try:
+            return _demonio.geometry(window_id)
+        except demonio_click.ErrorDemonio:
+            # la ventana ya no existe o es inválida
+            return None
     try:
         output = subprocess.check_output(["xdotool", "getwindowgeometry", "--shell", window_id]).decode("utf-8")
         geometry = {}
@@ -59,6 +80,12 @@ def _activate_window(window_id):
     """
     Activa la ventana especificada para asegurar que esté en foco.
     """
+    if _demonio:
+        try:
+            _demonio.activate(window_id)
+        except demonio_click.ErrorDemonio as e:
+            print(f"Advertencia: No se pudo activar la ventana {window_id}: {e}")
+        return
     try:
         subprocess.run(["xdotool", "windowactivate", window_id], check=True, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
         time.sleep(0.1) # Pequeña pausa para que el gestor de ventanas reaccione
@@ -93,10 +120,37 @@ def _get_random_absolute_coords(window_id):
     absolute_y = window_y + random_y_relative_to_window
     return absolute_x, absolute_y
 
+def _demonio_accion(window_id, button=None):
+    """
+    Con demonio, geometría + activación + movimiento/click van en un solo lote.
+    Si la ventana encogió y las coordenadas quedaron fuera, se reintenta una vez
+    con la geometría actual.
+    Retorna (absolute_x, absolute_y) o (None, None) si falla.
+    """
+    for _ in range(2):
+        geometry = _geometrias.get(window_id) or get_window_geometry(window_id)
+        if not geometry or geometry['WIDTH'] <= 0 or geometry['HEIGHT'] <= 0:
+            return None, None
+        relative_x = random.randint(0, geometry['WIDTH'] - 1)
+        relative_y = random.randint(0, geometry['HEIGHT'] - 1)
+        try:
+            _geometrias[window_id] = _demonio.accion(window_id, relative_x, relative_y, button)
+            return geometry['X'] + relative_x, geometry['Y'] + relative_y
+        except demonio_click.ErrorDemonio:
+            _geometrias.pop(window_id, None)
+    return None, None
+
 def perform_random_mouse_move(window_id):
     """
     Mueve el cursor del mouse visible a una posición aleatoria dentro de la ventana especificada.
     """
+    if _demonio:
+        absolute_x, absolute_y = _demonio_accion(window_id)
+        if absolute_x is None:
+            return False
+        print(f"Mouse movido a ({absolute_x}, {absolute_y}) en ventana {window_id}.")
+        return True
+
     absolute_x, absolute_y = _get_random_absolute_coords(window_id)
     if absolute_x is None:
         return False # Indicar que la acción no pudo realizarse
@@ -119,6 +173,14 @@ def perform_click(window_id, button):
     """
     Mueve el cursor a una posición aleatoria y realiza un click (1: izquierdo, 3: derecho).
     """
+    button_name = {1: "izquierdo", 3: "derecho"}.get(button, str(button))
+    if _demonio:
+        absolute_x, absolute_y = _demonio_accion(window_id, button)
+        if absolute_x is None:
+            return False
+        print(f"Click {button_name} en ({absolute_x}, {absolute_y}) en ventana {window_id}.")
+        return True
+
     absolute_x, absolute_y = _get_random_absolute_coords(window_id)
     if absolute_x is None:
         return False
@@ -126,7 +188,6 @@ def perform_click(window_id, button):
     _activate_window(window_id)
 
     try:
-        button_name = {1: "izquierdo", 3: "derecho"}.get(button, str(button))
         print(f"Moviendo mouse a ({absolute_x}, {absolute_y}) y haciendo click {button_name} en ventana {window_id}...")
         subprocess.run([
             "xdotool", "mousemove", str(absolute_x), str(absolute_y), "click", str(button)
@@ -142,15 +203,21 @@ def perform_scroll(window_id):
     """
     Mueve el cursor a una posición aleatoria y realiza un scroll (4: arriba, 5: abajo).
     """
+    scroll_direction = random.choice([4, 5]) # 4 for scroll up, 5 for scroll down
+    direction_name = "arriba" if scroll_direction == 4 else "abajo"
+    if _demonio:
+        absolute_x, absolute_y = _demonio_accion(window_id, scroll_direction)
+        if absolute_x is None:
+            return False
+        print(f"Scroll {direction_name} en ({absolute_x}, {absolute_y}) en ventana {window_id}.")
+        return True
+
     absolute_x, absolute_y = _get_random_absolute_coords(window_id)
     if absolute_x is None:
         return False
 
     _activate_window(window_id)
 
-    scroll_direction = random.choice([4, 5]) # 4 for scroll up, 5 for scroll down
-    direction_name = "arriba" if scroll_direction == 4 else "abajo"
-
     try:
         print(f"Moviendo mouse a ({absolute_x}, {absolute_y}) y haciendo scroll {direction_name} en ventana {window_id}...")
         subprocess.run([
@@ -164,6 +231,14 @@ def perform_scroll(window_id):
     return False
 
 def main():
+    global _demonio
+    # --sin-pausa: encadena las acciones sin la pausa aleatoria entre ellas
+    sin_pausa = "--sin-pausa" in sys.argv[1:]
+
+    _demonio = demonio_click.conectar()
+    if _demonio:
+        print("Usando demonio_click (una sola conexión X, sin subprocesos).")
+
     print("Buscando ventanas disponibles...")
     windows = get_windows()
 
@@ -244,7 +319,8 @@ def main():
                 break # Salir del bucle si una acción falla
             
             # Pausa aleatoria entre 0.5 y 2.5 segundos antes de la siguiente acción
-            time.sleep(random.uniform(0.5, 2.5))
+            if not sin_pausa:
+                time.sleep(random.uniform(0.5, 2.5))
 
         print(f"\nSe han completado las {i+1} acciones aleatorias en la ventana '{selected_window_title}'.")
 
@@ -0,0 +1,233 @@
+#ifndef CONVERSION_PIXELES_H
+#define CONVERSION_PIXELES_H
+
+// Conversión XImage -> RGB de 8 bits con flip vertical, repartida en bandas de filas.
+// Las bandas escriben directo en el buffer de subida; sus límites caen en múltiplos
+// de 64 bytes del destino para que dos hilos nunca compartan una línea de caché.
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <thread>
+#include <vector>
+#include "pool_hilos.h"
+
+const size_t CACHE_LINE = 64;
+const long MIN_PARALLEL_PIXELS = 256 * 1024; // por debajo, un solo hilo
+const long MIN_BAND_PIXELS = 64 * 1024;      // tamaño mínimo de cada banda
+const int BANDS_PER_THREAD = 4;              // margen para el robo de trabajo
+
+// ---------------- Buffer de subida ----------------
+// Se reutiliza entre frames; alineado a línea de caché.
+struct UploadBuffer {
+    unsigned char* data = nullptr;
+    size_t capacity = 0;
+
+    UploadBuffer() {}
+    UploadBuffer(const UploadBuffer&) = delete;
+    UploadBuffer& operator=(const UploadBuffer&) = delete;
+    ~UploadBuffer() { free(data); }
+
+    unsigned char* reserve(size_t bytes) {
+        if (bytes > capacity) {
+            free(data);
+            data = nullptr;
+            capacity = 0;
+            void* p = nullptr;
+            if (posix_memalign(&p, CACHE_LINE, bytes) != 0) return nullptr;
+            data = static_cast<unsigned char*>(p);
+            capacity = bytes;
+        }
+        return data;
+    }
+};
+
+// ---------------- Kernel de conversión ----------------
+struct ChannelShifts {
+    unsigned long rmask, gmask, bmask;
+    int rshift, gshift, bshift;
+};
+
+static inline ChannelShifts channel_shifts(const XImage* img) {
+    ChannelShifts cs;
+    cs.rmask = img->red_mask;
+    cs.gmask = img->green_mask;
+    cs.bmask = img->blue_mask;
+    cs.rshift = 0; while (!((cs.rmask >> cs.rshift) & 1) && cs.rshift < 32) cs.rshift++;
+    cs.gshift = 0; while (!((cs.gmask >> cs.gshift) & 1) && cs.gshift < 32) cs.gshift++;
+    cs.bshift = 0; while (!((cs.bmask >> cs.bshift) & 1) && cs.bshift < 32) cs.bshift++;
+    return cs;
+}
+
+static inline bool host_is_lsb_first() {
+    const int one = 1;
+    return *reinterpret_cast<const char*>(&one) == 1;
+}
+
+// Convierte las filas destino [t0, t1); la fila destino t sale de la fila origen height-1-t.
+static inline void convert_rows_rgb(XImage* img, const ChannelShifts& cs, unsigned char* dst, int t0, int t1) {
+    int width = img->width;
+    int height = img->height;
+    bool direct32 = img->bits_per_pixel == 32 &&
+                    (img->byte_order == LSBFirst) == host_is_lsb_first();
+
+    for (int ty = t0; ty < t1; ++ty) {
+        int y = height - 1 - ty;
+        unsigned char* out = dst + (size_t)ty * width * 3;
+        if (direct32) {
+            // lectura directa de palabras de 32 bits en el orden del host, sin XGetPixel
+            const uint32_t* src = reinterpret_cast<const uint32_t*>(img->data + (size_t)y * img->bytes_per_line);
+            for (int x = 0; x < width; ++x) {
+                uint32_t p = src[x];
+                out[0] = ((p & cs.rmask) >> cs.rshift) & 0xFF;
+                out[1] = ((p & cs.gmask) >> cs.gshift) & 0xFF;
+                out[2] = ((p & cs.bmask) >> cs.bshift) & 0xFF;
+                out += 3;
+            }
+        } else {
+            for (int x = 0; x < width; ++x) {
+                unsigned long p = XGetPixel(img, x, y);
+                out[0] = ((p & cs.rmask) >> cs.rshift) & 0xFF;
+                out[1] = ((p & cs.gmask) >> cs.gshift) & 0xFF;
+                out[2] = ((p & cs.bmask) >> cs.bshift) & 0xFF;
+                out += 3;
+            }
+        }
+    }
+}
+
+// ---------------- Copia directa en BGRA ----------------
+// En un host little-endian, un XImage de 32 bpp con máscaras 0xFF0000/0xFF00/0xFF ya
+// está en memoria como BGRA de 8 bits: se sube tal cual con GL_BGRA, sin convertir.
+static inline bool image_is_native_bgra(const XImage* img) {
+    return img->bits_per_pixel == 32 && img->byte_order == LSBFirst && host_is_lsb_first() &&
+           img->red_mask == 0xFF0000 && img->green_mask == 0xFF00 && img->blue_mask == 0xFF;
+}
+
+// Copia las filas con flip vertical a 'dst' (width*height*4 bytes); solo para image_is_native_bgra().
+static inline void copy_rows_bgra(const XImage* img, unsigned char* dst) {
+    size_t rowBytes = (size_t)img->width * 4;
+    for (int ty = 0; ty < img->height; ++ty)
+        memcpy(dst + (size_t)ty * rowBytes,
+               img->data + (size_t)(img->height - 1 - ty) * img->bytes_per_line, rowBytes);
+}
+
+// ---------------- Reducción ----------------
+// Reducción por promedio de caja: cada pixel destino es la media de su área en el origen.
+// Requiere dw <= sw y dh <= sh.
+static inline void downscale_box_rgb(const unsigned char* src, int sw, int sh,
+                                     unsigned char* dst, int dw, int dh) {
+    std::vector<int> xs(dw + 1);
+    for (int x = 0; x <= dw; ++x) xs[x] = (int)((long)x * sw / dw);
+
+    for (int dy = 0; dy < dh; ++dy) {
+        int y0 = (int)((long)dy * sh / dh);
+        int y1 = (int)((long)(dy + 1) * sh / dh);
+        if (y1 <= y0) y1 = y0 + 1;
+        unsigned char* out = dst + (size_t)dy * dw * 3;
+        for (int dx = 0; dx < dw; ++dx) {
+            int x0 = xs[dx], x1 = xs[dx + 1] > x0 ? xs[dx + 1] : x0 + 1;
+            unsigned int sr = 0, sg = 0, sb = 0;
+            for (int y = y0; y < y1; ++y) {
+                const unsigned char* p = src + ((size_t)y * sw + x0) * 3;
+                for (int x = x0; x < x1; ++x, p += 3) {
+                    sr += p[0]; sg += p[1]; sb += p[2];
+                }
+            }
+            unsigned int n = (unsigned int)(y1 - y0) * (x1 - x0);
+            out[0] = (sr + n / 2) / n;
+            out[1] = (sg + n / 2) / n;
+            out[2] = (sb + n / 2) / n;
+            out += 3;
+        }
+    }
+}
+
+// ---------------- Reparto en bandas ----------------
+static inline int gcd_int(int a, int b) {
+    while (b) { int t = a % b; a = b; b = t; }
+    return a;
+}
+
+// Filas por banda: múltiplo de las filas necesarias para que cada banda empiece
+// en un límite de línea de caché del destino, y con al menos MIN_BAND_PIXELS.
+static inline int rows_per_band(int width, int height, int threads) {
+    int rowBytes = width * 3;
+    int alignRows = (int)CACHE_LINE / gcd_int(rowBytes, (int)CACHE_LINE);
+    int minRows = (int)((MIN_BAND_PIXELS + width - 1) / width);
+    int target = (height + threads * BANDS_PER_THREAD - 1) / (threads * BANDS_PER_THREAD);
+    int rows = target > minRows ? target : minRows;
+    return (rows + alignRows - 1) / alignRows * alignRows;
+}
+
+// Convierte la imagen completa a 'dst' (width*height*3 bytes, alineado a CACHE_LINE).
+// Las imágenes chicas se convierten en el hilo actual: el despacho costaría más que la conversión.
+static inline void convert_image_rgb(XImage* img, unsigned char* dst, ThreadPool* pool) {
+    ChannelShifts cs = channel_shifts(img);
+    int width = img->width;
+    int height = img->height;
+
+    if (!pool || pool->size() == 1 || (long)width * height < MIN_PARALLEL_PIXELS) {
+        convert_rows_rgb(img, cs, dst, 0, height);
+        return;
+    }
+
+    int rows = rows_per_band(width, height, pool->size());
+    int nbands = (height + rows - 1) / rows;
+    pool->parallel_for(nbands, [&](int band) {
+        int t0 = band * rows;
+        int t1 = t0 + rows < height ? t0 + rows : height;
+        convert_rows_rgb(img, cs, dst, t0, t1);
+    });
+}
+
+static inline int default_thread_count() {
+    unsigned int n = std::thread::hardware_concurrency();
+    return n ? (int)n : 1;
+}
+
+static inline double seconds_now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Mide la conversión de 'img' con 1..maxThreads hilos e imprime ms por frame y aceleración.
+static inline void benchmark_conversion_threads(XImage* img, int maxThreads, int reps) {
+    UploadBuffer buf;
+    unsigned char* dst = buf.reserve((size_t)img->width * img->height * 3);
+    if (!dst) return;
+
+    printf("Conversión %dx%d (%d bpp), %d repeticiones\n", img->width, img->height, img->bits_per_pixel, reps);
+    double base = 0.0;
+    for (int t = 1; t <= maxThreads; ++t) {
+        ThreadPool pool(t);
+        convert_image_rgb(img, dst, &pool); // calentamiento
+        double t0 = seconds_now();
+        for (int r = 0; r < reps; ++r) convert_image_rgb(img, dst, &pool);
+        double ms = (seconds_now() - t0) * 1000.0 / reps;
+        if (t == 1) base = ms;
+        printf("  %2d hilos: %8.3f ms/frame  %7.1f Mpix/s  x%.2f\n", t, ms,
+               (double)img->width * img->height / (ms * 1000.0), base / ms);
+    }
+}
+
+// Captura 'w' una vez y mide su conversión (modo --bench-hilos de los gestores).
+static inline int benchmark_window_conversion(Display* dpy, Window w, int maxThreads) {
+    XWindowAttributes wa;
+    if (!XGetWindowAttributes(dpy, w, &wa)) return 1;
+    XImage* img = XGetImage(dpy, w, 0, 0, wa.width, wa.height, AllPlanes, ZPixmap);
+    if (!img) {
+        fprintf(stderr, "No se pudo capturar la ventana para el benchmark\n");
+        return 1;
+    }
+    benchmark_conversion_threads(img, maxThreads, 20);
+    XDestroyImage(img);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,449 @@
+#include <X11/Xlib.h>
+#include <X11/Xatom.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/XTest.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <map>
+#include <cstring>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+
+// Demonio de automatización: mantiene una sola conexión X y un caché de ventanas,
+// y atiende comandos por un socket Unix con un protocolo de una línea por comando.
+//
+//   L                      -> OK <n>, seguido de n líneas "<id> <título>"
+//                             (en el título, '\\', '\n' y '\r' van escapados con '\\')
+//   G <id>                 -> OK <x> <y> <ancho> <alto>   (coordenadas absolutas)
+//   A <id>                 -> OK                           (activar ventana)
+//   M <id> <x> <y>         -> OK                           (mover el puntero, relativo a la ventana)
+//   C <id> <x> <y> <botón> -> OK                           (mover y click; 4/5 = scroll)
+//   E <id> <x> <y>         -> OK                           (click sintético sin mover el puntero)
+//
+// Los errores se responden como "ERR <motivo>". Se pueden enviar muchos comandos
+// seguidos: las respuestas salen en orden y se hace un solo XFlush por lote.
+
+struct WindowInfo {
+    Window id;
+    std::string title;
+    bool geometryValid;
+    int x, y, width, height;
+};
+
+struct Client {
+    int fd;
+    std::string in, out;
+};
+
+Display* dpy = nullptr;
+Window root = 0;
+std::map<Window, WindowInfo> g_cache;
+std::vector<Window> g_order;     // orden de listado (recorrido del árbol)
+bool g_cacheDirty = true;
+bool g_netActiveSupported = false;
+Atom a_wmName, a_netWmName, a_netActive;
+
+// ---------------- Manejo de errores X ----------------
+static int trapped_error_code = 0;
+int x_error_handler(Display*, XErrorEvent* error) {
+    trapped_error_code = error->error_code;
+    return 0;
+}
+// fuera de una trampa, un error X (p. ej. ventana destruida en medio de un lote)
+// no debe terminar el demonio
+int x_log_handler(Display* d, XErrorEvent* error) {
+    char text[128];
+    XGetErrorText(d, error->error_code, text, sizeof(text));
+    fprintf(stderr, "Error X ignorado: %s\n", text);
+    return 0;
+}
+void start_xerror_trap() {
+    trapped_error_code = 0;
+    XSync(dpy, False);
+    XSetErrorHandler(x_error_handler);
+}
+bool end_xerror_trap() {
+    XSync(dpy, False);
+    XSetErrorHandler(x_log_handler);
+    return trapped_error_code != 0;
+}
+
+// ---------------- Caché de ventanas ----------------
+std::string getWindowTitle(Display* dpy, Window w) {
+    Atom type;
+    int format;
+    unsigned long nitems, bytes_after;
+    unsigned char* prop_ret = nullptr;
+
+    if (XGetWindowProperty(dpy, w, a_wmName, 0, (~0L), False, AnyPropertyType,
+                           &type, &format, &nitems, &bytes_after, &prop_ret) == Success) {
+        if (prop_ret) {
+            std::string title(reinterpret_cast<char*>(prop_ret));
+            XFree(prop_ret);
+            return title;
+        }
+    }
+    return "";
+}
+
+void listWindowsRec(Display* dpy, Window parent, std::vector<WindowInfo>& windows) {
+    Window root_ret, parent_ret;
+    Window* children;
+    unsigned int nchildren;
+    if (XQueryTree(dpy, parent, &root_ret, &parent_ret, &children, &nchildren)) {
+        for (unsigned int i = 0; i < nchildren; i++) {
+            std::string title = getWindowTitle(dpy, children[i]);
+            if (!title.empty())
+                windows.push_back({ children[i], title, false, 0, 0, 0, 0 });
+            listWindowsRec(dpy, children[i], windows);
+        }
+        if (children)
+            XFree(children);
+    }
+}
+
+void refreshCache() {
+    std::vector<WindowInfo> windows;
+    start_xerror_trap();
+    listWindowsRec(dpy, root, windows);
+    end_xerror_trap();
+
+    std::map<Window, WindowInfo> fresh;
+    g_order.clear();
+    start_xerror_trap();
+    for (WindowInfo &w : windows) {
+        auto old = g_cache.find(w.id);
+        if (old != g_cache.end()) {
+            w.geometryValid = old->second.geometryValid;
+            w.x = old->second.x; w.y = old->second.y;
+            w.width = old->second.width; w.height = old->second.height;
+        } else {
+            // eventos de tamaño, destrucción y cambio de título de cada ventana
+            XSelectInput(dpy, w.id, StructureNotifyMask | PropertyChangeMask);
+        }
+        fresh[w.id] = w;
+        g_order.push_back(w.id);
+    }
+    end_xerror_trap();
+
+    g_cache.swap(fresh);
+    g_cacheDirty = false;
+}
+
+WindowInfo* lookup(Window id) {
+    bool refreshed = g_cacheDirty;
+    if (g_cacheDirty) refreshCache();
+    auto it = g_cache.find(id);
+    // solo se ven los eventos de las hijas de la raíz: una ventana creada dentro
+    // de otra (p. ej. en el marco del gestor de ventanas) no marca el caché como
+    // sucio, así que ante un fallo se vuelve a recorrer el árbol una vez
+    if (it == g_cache.end() && !refreshed) {
+        refreshCache();
+        it = g_cache.find(id);
+    }
+    return it == g_cache.end() ? nullptr : &it->second;
+}
+
+bool updateGeometry(WindowInfo &w) {
+    if (w.geometryValid) return true;
+
+    XWindowAttributes attr;
+    Window child;
+    int ax = 0, ay = 0;
+    start_xerror_trap();
+    Status ok = XGetWindowAttributes(dpy, w.id, &attr);
+    if (ok) XTranslateCoordinates(dpy, w.id, root, 0, 0, &ax, &ay, &child);
+    bool failed = end_xerror_trap();
+    if (!ok || failed) return false;
+
+    w.x = ax;
+    w.y = ay;
+    w.width = attr.width;
+    w.height = attr.height;
+    w.geometryValid = true;
+    return true;
+}
+
+void handleXEvent(const XEvent &ev) {
+    switch (ev.type) {
+    case CreateNotify:
+    case DestroyNotify:
+    case ReparentNotify:
+    case MapNotify:
+    case UnmapNotify:
+        g_cacheDirty = true;
+        break;
+    case ConfigureNotify:
+        // mover un marco del gestor de ventanas mueve a todas sus hijas
+        for (auto &entry : g_cache) entry.second.geometryValid = false;
+        break;
+    case PropertyNotify:
+        if (ev.xproperty.atom == a_wmName || ev.xproperty.atom == a_netWmName) {
+            auto it = g_cache.find(ev.xproperty.window);
+            if (it != g_cache.end()) it->second.title = getWindowTitle(dpy, it->first);
+        }
+        break;
+    }
+}
+
+// ---------------- Acciones ----------------
+void activateWindow(Window w) {
+    if (g_netActiveSupported) {
+        XEvent event;
+        memset(&event, 0, sizeof(event));
+        event.xclient.type = ClientMessage;
+        event.xclient.window = w;
+        event.xclient.message_type = a_netActive;
+        event.xclient.format = 32;
+        event.xclient.data.l[0] = 2; // fuente: herramienta de automatización
+        event.xclient.data.l[1] = CurrentTime;
+        XSendEvent(dpy, root, False, SubstructureRedirectMask | SubstructureNotifyMask, &event);
+    } else {
+        XRaiseWindow(dpy, w);
+        XSetInputFocus(dpy, w, RevertToParent, CurrentTime);
+    }
+}
+
+void movePointer(int x, int y) {
+    XTestFakeMotionEvent(dpy, DefaultScreen(dpy), x, y, CurrentTime);
+}
+
+void clickButton(unsigned int button) {
+    XTestFakeButtonEvent(dpy, button, True, CurrentTime);
+    XTestFakeButtonEvent(dpy, button, False, CurrentTime);
+}
+
+void sendClick(Display* dpy, Window w, int x, int y) {
+    XEvent event;
+    memset(&event, 0, sizeof(event));
+
+    event.xbutton.type = ButtonPress;
+    event.xbutton.button = Button1;
+    event.xbutton.same_screen = True;
+    event.xbutton.x = x;
+    event.xbutton.y = y;
+    event.xbutton.window = w;
+
+    XSendEvent(dpy, w, True, ButtonPressMask, &event);
+
+    event.xbutton.type = ButtonRelease;
+    XSendEvent(dpy, w, True, ButtonReleaseMask, &event);
+}
+
+// ---------------- Protocolo ----------------
+// Un título con saltos de línea rompería el listado de una línea por ventana.
+void appendEscaped(std::string &out, const std::string &text) {
+    for (char c : text) {
+        if (c == '\\') out += "\\\\";
+        else if (c == '\n') out += "\\n";
+        else if (c == '\r') out += "\\r";
+        else out += c;
+    }
+}
+
+void runCommand(const std::string &line, std::string &out) {
+    char op = 0;
+    unsigned long id = 0;
+    int x = 0, y = 0;
+    unsigned int button = 1;
+    char reply[128];
+
+    if (line.empty()) return;
+    op = line[0];
+    int n = sscanf(line.c_str() + 1, "%lx %d %d %u", &id, &x, &y, &button);
+
+    if (op == 'L') {
+        if (g_cacheDirty) refreshCache();
+        snprintf(reply, sizeof(reply), "OK %zu\n", g_order.size());
+        out += reply;
+        for (Window w : g_order) {
+            snprintf(reply, sizeof(reply), "0x%08lx ", w);
+            out += reply;
+            appendEscaped(out, g_cache[w].title);
+            out += '\n';
+        }
+        return;
+    }
+
+    if (n < 1) { out += "ERR falta el id de ventana\n"; return; }
+    WindowInfo* w = lookup(id);
+    if (!w || !updateGeometry(*w)) { out += "ERR ventana inexistente\n"; return; }
+
+    switch (op) {
+    case 'G':
+        snprintf(reply, sizeof(reply), "OK %d %d %d %d\n", w->x, w->y, w->width, w->height);
+        out += reply;
+        return;
+    case 'A':
+        activateWindow(w->id);
+        out += "OK\n";
+        return;
+    case 'M':
+    case 'C':
+    case 'E':
+        if (n < 3) break;
+        if (x < 0 || y < 0 || x >= w->width || y >= w->height) {
+            out += "ERR coordenadas fuera de la ventana\n";
+            return;
+        }
+        if (op == 'E') {
+            sendClick(dpy, w->id, x, y);
+        } else {
+            movePointer(w->x + x, w->y + y);
+            if (op == 'C') clickButton(n >= 4 ? button : 1);
+        }
+        out += "OK\n";
+        return;
+    }
+    out += "ERR comando inválido\n";
+}
+
+// Procesa todas las líneas completas recibidas; devuelve false si el cliente cerró.
+bool serveClient(Client &c) {
+    char buf[4096];
+    for (;;) {
+        ssize_t r = read(c.fd, buf, sizeof(buf));
+        if (r > 0) { c.in.append(buf, r); continue; }
+        if (r == 0) return false;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+        if (errno != EINTR) return false;
+    }
+
+    size_t start = 0, nl;
+    bool ran = false;
+    while ((nl = c.in.find('\n', start)) != std::string::npos) {
+        runCommand(c.in.substr(start, nl - start), c.out);
+        start = nl + 1;
+        ran = true;
+    }
+    c.in.erase(0, start);
+    if (ran) XFlush(dpy);
+    return true;
+}
+
+bool flushClient(Client &c) {
+    while (!c.out.empty()) {
+        ssize_t w = write(c.fd, c.out.data(), c.out.size());
+        if (w > 0) { c.out.erase(0, w); continue; }
+        if (w < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+        if (w < 0 && errno == EINTR) continue;
+        return false;
+    }
+    return true;
+}
+
+std::string defaultSocketPath() {
+    const char* dir = getenv("XDG_RUNTIME_DIR");
+    std::string path = dir ? dir : "/tmp";
+    return path + "/demonio_click-" + std::to_string(getuid()) + ".sock";
+}
+
+int main(int argc, char** argv) {
+    std::string path = argc > 1 ? argv[1] : defaultSocketPath();
+
+    dpy = XOpenDisplay(NULL);
+    if (!dpy) {
+        std::cerr << "❌ No se pudo abrir la pantalla X11.\n";
+        return 1;
+    }
+    int ev_base, err_base, major, minor;
+    if (!XTestQueryExtension(dpy, &ev_base, &err_base, &major, &minor)) {
+        std::cerr << "❌ El servidor X no tiene la extensión XTEST.\n";
+        return 1;
+    }
+
+    XSetErrorHandler(x_log_handler);
+    root = DefaultRootWindow(dpy);
+    a_wmName = XInternAtom(dpy, "WM_NAME", False);
+    a_netWmName = XInternAtom(dpy, "_NET_WM_NAME", False);
+    a_netActive = XInternAtom(dpy, "_NET_ACTIVE_WINDOW", False);
+
+    // ¿el gestor de ventanas soporta _NET_ACTIVE_WINDOW?
+    Atom type;
+    int format;
+    unsigned long nitems, bytes_after;
+    unsigned char* prop = nullptr;
+    if (XGetWindowProperty(dpy, root, XInternAtom(dpy, "_NET_SUPPORTED", False), 0, 4096, False,
+                           XA_ATOM, &type, &format, &nitems, &bytes_after, &prop) == Success && prop) {
+        Atom* atoms = reinterpret_cast<Atom*>(prop);
+        for (unsigned long i = 0; i < nitems; ++i)
+            if (atoms[i] == a_netActive) g_netActiveSupported = true;
+        XFree(prop);
+    }
+
+    XSelectInput(dpy, root, SubstructureNotifyMask);
+    refreshCache();
+
+    int lfd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (lfd < 0 || path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "❌ No se pudo crear el socket " << path << "\n";
+        return 1;
+    }
+    strcpy(addr.sun_path, path.c_str());
+    unlink(path.c_str());
+    if (bind(lfd, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(lfd, 16) < 0) {
+        std::cerr << "❌ No se pudo escuchar en " << path << ": " << strerror(errno) << "\n";
+        return 1;
+    }
+    fcntl(lfd, F_SETFL, O_NONBLOCK);
+    signal(SIGPIPE, SIG_IGN);
+
+    std::cout << "🖱️ Demonio escuchando en " << path << " (" << g_order.size() << " ventanas)\n";
+
+    std::vector<Client> clients;
+    int xfd = ConnectionNumber(dpy);
+
+    for (;;) {
+        while (XPending(dpy)) {
+            XEvent ev;
+            XNextEvent(dpy, &ev);
+            handleXEvent(ev);
+        }
+
+        std::vector<pollfd> fds;
+        fds.push_back({ lfd, POLLIN, 0 });
+        fds.push_back({ xfd, POLLIN, 0 });
+        for (Client &c : clients)
+            fds.push_back({ c.fd, (short)(POLLIN | (c.out.empty() ? 0 : POLLOUT)), 0 });
+
+        if (poll(fds.data(), fds.size(), -1) < 0 && errno != EINTR) break;
+
+        if (fds[0].revents & POLLIN) {
+            int cfd;
+            while ((cfd = accept(lfd, nullptr, nullptr)) >= 0) {
+                fcntl(cfd, F_SETFL, O_NONBLOCK);
+                clients.push_back({ cfd, "", "" });
+            }
+        }
+
+        for (size_t i = 0; i < clients.size(); ) {
+            short re = fds.size() > i + 2 ? fds[i + 2].revents : 0;
+            bool alive = true;
+            if (re & (POLLIN | POLLHUP | POLLERR)) alive = serveClient(clients[i]);
+            if (alive) alive = flushClient(clients[i]);
+            if (!alive) {
+                close(clients[i].fd);
+                clients.erase(clients.begin() + i);
+                fds.erase(fds.begin() + i + 2);
+                continue;
+            }
+            ++i;
+        }
+    }
+
+    close(lfd);
+    unlink(path.c_str());
+    XCloseDisplay(dpy);
+    return 0;
+}
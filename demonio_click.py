@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+
+"""
+Cliente del demonio de automatización (demonio_click.cpp).
+Habla el protocolo de una línea por comando sobre el socket Unix del demonio.
+"""
+
+import os
+import socket
+
+
+def ruta_socket_por_defecto():
+    directorio = os.environ.get("XDG_RUNTIME_DIR", "/tmp")
+    return os.path.join(directorio, f"demonio_click-{os.getuid()}.sock")
+
+
+class ErrorDemonio(Exception):
+    pass
+
+
+def _desescapar(texto):
+    r"""Deshace el escape de '\\', '\n' y '\r' con que el demonio envía los títulos."""
+    if "\\" not in texto:
+        return texto
+    salida = []
+    i = 0
+    while i < len(texto):
+        c = texto[i]
+        if c == "\\" and i + 1 < len(texto):
+            i += 1
+            c = {"n": "\n", "r": "\r"}.get(texto[i], texto[i])
+        salida.append(c)
+        i += 1
+    return "".join(salida)
+
+
+class DemonioClick:
+    def __init__(self, ruta=None):
+        self.sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        self.sock.connect(ruta or ruta_socket_por_defecto())
+        self.archivo = self.sock.makefile("rb")
+
+    def close(self):
+        self.archivo.close()
+        self.sock.close()
+
+    def _leer_linea(self):
+        linea = self.archivo.readline()
+        if not linea:
+            raise ErrorDemonio("el demonio cerró la conexión")
+        return linea.decode("utf-8", "replace").rstrip("\n")
+
+    def _leer_respuesta(self, comando):
+        """Lee la respuesta de un comando; para 'L' incluye las líneas del listado."""
+        linea = self._leer_linea()
+        if comando.startswith("L") and linea.startswith("OK "):
+            n = int(linea.split()[1])
+            return [linea] + [self._leer_linea() for _ in range(n)]
+        return [linea]
+
+    def batch(self, comandos):
+        """
+        Envía varios comandos de una sola vez y devuelve la lista de respuestas
+        (una lista de líneas por comando), en el mismo orden.
+        """
+        self.sock.sendall("".join(c + "\n" for c in comandos).encode("utf-8"))
+        return [self._leer_respuesta(c) for c in comandos]
+
+    def _ejecutar(self, comando):
+        respuesta = self.batch([comando])[0]
+        if not respuesta[0].startswith("OK"):
+            raise ErrorDemonio(respuesta[0])
+        return respuesta
+
+    def list_windows(self):
+        """Lista de tuplas (ID de ventana, Título de ventana)."""
+        lineas = self._ejecutar("L")[1:]
+        ventanas = []
+        for linea in lineas:
+            window_id, _, title = linea.partition(" ")
+            ventanas.append((window_id, _desescapar(title)))
+        return ventanas
+
+    @staticmethod
+    def _geometria(linea):
+        x, y, w, h = (int(v) for v in linea.split()[1:])
+        return {"X": x, "Y": y, "WIDTH": w, "HEIGHT": h}
+
+    def geometry(self, window_id):
+        """Diccionario con 'X', 'Y', 'WIDTH', 'HEIGHT' (coordenadas absolutas)."""
+        return self._geometria(self._ejecutar(f"G {window_id}")[0])
+
+    def accion(self, window_id, x, y, button=None):
+        """
+        Activa la ventana y mueve el puntero a (x, y) relativo a ella, haciendo
+        click si se da 'button', en un solo lote (G + A + M/C, una ida y vuelta).
+        Devuelve la geometría de la ventana leída en ese mismo lote.
+        """
+        if button is None:
+            final = f"M {window_id} {x} {y}"
+        else:
+            final = f"C {window_id} {x} {y} {button}"
+        respuestas = self.batch([f"G {window_id}", f"A {window_id}", final])
+        for respuesta in respuestas:
+            if not respuesta[0].startswith("OK"):
+                raise ErrorDemonio(respuesta[0])
+        return self._geometria(respuestas[0][0])
+
+    def activate(self, window_id):
+        self._ejecutar(f"A {window_id}")
+
+    def move(self, window_id, x, y):
+        """Mueve el puntero a (x, y) relativo a la ventana."""
+        self._ejecutar(f"M {window_id} {x} {y}")
+
+    def click(self, window_id, x, y, button=1):
+        """Mueve el puntero a (x, y) relativo a la ventana y hace click (4/5 = scroll)."""
+        self._ejecutar(f"C {window_id} {x} {y} {button}")
+
+    def click_sin_mover(self, window_id, x, y):
+        """Envía un click sintético a la ventana sin mover el puntero."""
+        self._ejecutar(f"E {window_id} {x} {y}")
+
+
+def conectar(ruta=None):
+    """Devuelve un DemonioClick conectado, o None si el demonio no está corriendo."""
+    try:
+        return DemonioClick(ruta)
+    except OSError:
+        return None
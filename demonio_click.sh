@@ -0,0 +1,3 @@
+#!/bin/sh
+
+g++ demonio_click.cpp -o demonio_click -lX11 -lXtst
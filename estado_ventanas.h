@@ -0,0 +1,82 @@
+#ifndef ESTADO_VENTANAS_H
+#define ESTADO_VENTANAS_H
+
+// Estado de cada ventana mantenido con eventos X (Map/Unmap, VisibilityNotify,
+// ConfigureNotify y cambios de _NET_WM_STATE), para decidir sin ir al servidor si
+// vale la pena capturarla: una ventana sin mapear, oculta o tapada del todo no
+// produce píxeles útiles y XGetImage solo devolvería basura o un error.
+
+#include <X11/Xlib.h>
+#include <X11/Xatom.h>
+
+struct CaptureGate {
+    bool mapped = false;
+    bool hidden = false;                     // _NET_WM_STATE_HIDDEN (minimizada)
+    int visibility = VisibilityUnobscured;   // sin evento todavía: se asume visible
+    int width = 0, height = 0;               // geometría de ConfigureNotify
+
+    bool can_capture() const {
+        return mapped && !hidden && visibility != VisibilityFullyObscured && width > 0 && height > 0;
+    }
+};
+
+static inline bool read_hidden_state(Display* dpy, Window w) {
+    Atom net_wm_state = XInternAtom(dpy, "_NET_WM_STATE", False);
+    Atom state_hidden = XInternAtom(dpy, "_NET_WM_STATE_HIDDEN", False);
+    Atom actual_type;
+    int actual_format;
+    unsigned long nitems, bytes_after;
+    unsigned char* prop = nullptr;
+    bool hidden = false;
+
+    if (XGetWindowProperty(dpy, w, net_wm_state, 0, 64, False, XA_ATOM,
+                           &actual_type, &actual_format, &nitems, &bytes_after, &prop) == Success && prop) {
+        Atom* atoms = reinterpret_cast<Atom*>(prop);
+        for (unsigned long i = 0; i < nitems; ++i)
+            if (atoms[i] == state_hidden) hidden = true;
+        XFree(prop);
+    }
+    return hidden;
+}
+
+// Suscribe 'w' a los eventos del estado y arma el estado inicial desde 'wa'.
+// Map/Unmap/Configure llegan por SubstructureNotifyMask de la raíz.
+static inline void gate_init(Display* dpy, Window w, const XWindowAttributes &wa, CaptureGate &g) {
+    XSelectInput(dpy, w, VisibilityChangeMask | PropertyChangeMask);
+    g.mapped = wa.map_state == IsViewable;
+    g.width = wa.width;
+    g.height = wa.height;
+    g.hidden = read_hidden_state(dpy, w);
+}
+
+// Ventana a la que se refiere un evento de estado, o None si no es uno de ellos.
+static inline Window gate_event_window(const XEvent &ev) {
+    switch (ev.type) {
+    case MapNotify: return ev.xmap.window;
+    case UnmapNotify: return ev.xunmap.window;
+    case ConfigureNotify: return ev.xconfigure.window;
+    case VisibilityNotify: return ev.xvisibility.window;
+    case PropertyNotify: return ev.xproperty.window;
+    case DestroyNotify: return ev.xdestroywindow.window;
+    }
+    return None;
+}
+
+// Aplica un evento de la ventana al estado; DestroyNotify lo maneja quien lleva el registro.
+static inline void gate_update(Display* dpy, const XEvent &ev, CaptureGate &g) {
+    switch (ev.type) {
+    case MapNotify: g.mapped = true; break;
+    case UnmapNotify: g.mapped = false; break;
+    case ConfigureNotify:
+        g.width = ev.xconfigure.width;
+        g.height = ev.xconfigure.height;
+        break;
+    case VisibilityNotify: g.visibility = ev.xvisibility.state; break;
+    case PropertyNotify:
+        if (ev.xproperty.atom == XInternAtom(dpy, "_NET_WM_STATE", False))
+            g.hidden = read_hidden_state(dpy, ev.xproperty.window);
+        break;
+    }
+}
+
+#endif
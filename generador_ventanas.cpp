@@ -0,0 +1,139 @@
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <unistd.h>
+#include <signal.h>
+#include <time.h>
+
+// Generador de ventanas para pruebas de resistencia: crea, redimensiona, oculta
+// y destruye ventanas sin parar, cada una pintada de un color liso.
+// Uso: generador_ventanas [operaciones_por_segundo] [max_ventanas] [segundos]
+// La mitad de las operaciones crea una ventana; con el máximo alcanzado, antes se
+// destruye otra. Con 200 operaciones por segundo (por defecto) son unas 6000 ventanas
+// nuevas por minuto, sin importar el máximo; 0 segundos = sin fin.
+// Cada 10 s y al terminar (también con SIGTERM/SIGINT) informa cuántas creó por minuto.
+
+static double now_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static volatile sig_atomic_t g_stop = 0;
+static void on_signal(int) { g_stop = 1; }
+
+struct Generated {
+    Window w;
+    unsigned long color;
+    bool mapped;
+};
+
+static void paint(Display* dpy, GC gc, const Generated &g, int width, int height) {
+    XSetForeground(dpy, gc, g.color);
+    XFillRectangle(dpy, g.w, gc, 0, 0, width, height);
+}
+
+int main(int argc, char** argv) {
+    double rate = argc > 1 ? atof(argv[1]) : 200.0;
+    int maxWindows = argc > 2 ? atoi(argv[2]) : 50;
+    double duration = argc > 3 ? atof(argv[3]) : 0.0;
+    if (rate <= 0) rate = 1;
+    if (maxWindows < 1) maxWindows = 1;
+
+    Display* dpy = XOpenDisplay(nullptr);
+    if (!dpy) {
+        fprintf(stderr, "No se pudo abrir X display\n");
+        return 1;
+    }
+
+    int screen = DefaultScreen(dpy);
+    Window root = DefaultRootWindow(dpy);
+    int screenW = DisplayWidth(dpy, screen);
+    int screenH = DisplayHeight(dpy, screen);
+    GC gc = XCreateGC(dpy, root, 0, nullptr);
+    srand(1234);
+    signal(SIGTERM, on_signal);
+    signal(SIGINT, on_signal);
+
+    std::vector<Generated> live;
+    unsigned long created = 0, resized = 0, toggled = 0, destroyed = 0;
+    double start = now_seconds();
+    double next = start;
+    double nextReport = start + 10.0;
+
+    while (!g_stop && (duration <= 0 || now_seconds() - start < duration)) {
+        int op = rand() % 10;
+        int width = 16 + rand() % (screenW / 2);
+        int height = 16 + rand() % (screenH / 2);
+
+        if (op < 5 && (int)live.size() >= maxWindows) {
+            // lleno: se hace lugar para que la tasa de altas no dependa del máximo
+            size_t k = rand() % live.size();
+            XDestroyWindow(dpy, live[k].w);
+            live[k] = live.back();
+            live.pop_back();
+            destroyed++;
+        }
+        if (live.empty() || op < 5) {
+            Generated g;
+            g.color = (unsigned long)rand() & 0xFFFFFF;
+            g.w = XCreateSimpleWindow(dpy, root, rand() % screenW, rand() % screenH,
+                                      width, height, 0, g.color, g.color);
+            g.mapped = true;
+            char name[64];
+            snprintf(name, sizeof(name), "Generada %lu", created);
+            XStoreName(dpy, g.w, name);
+            XMapWindow(dpy, g.w);
+            paint(dpy, gc, g, width, height);
+            live.push_back(g);
+            created++;
+        } else {
+            size_t k = rand() % live.size();
+            Generated &g = live[k];
+            if (op < 7) {
+                XResizeWindow(dpy, g.w, width, height);
+                paint(dpy, gc, g, width, height);
+                resized++;
+            } else if (op < 8) {
+                if (g.mapped) XUnmapWindow(dpy, g.w);
+                else XMapWindow(dpy, g.w);
+                g.mapped = !g.mapped;
+                toggled++;
+            } else {
+                XDestroyWindow(dpy, g.w);
+                live[k] = live.back();
+                live.pop_back();
+                destroyed++;
+            }
+        }
+        XFlush(dpy);
+
+        // descartar eventos: no se escucha ninguno, pero por las dudas
+        while (XPending(dpy)) {
+            XEvent ev;
+            XNextEvent(dpy, &ev);
+        }
+
+        double t = now_seconds();
+        if (t >= nextReport) {
+            printf("Generador: %lu creadas (%.0f por minuto), %zu vivas\n",
+                   created, created * 60.0 / (t - start), live.size());
+            fflush(stdout);
+            nextReport += 10.0;
+        }
+
+        next += 1.0 / rate;
+        double wait = next - now_seconds();
+        if (wait > 0) usleep((useconds_t)(wait * 1e6));
+        else next = now_seconds(); // atrasado: no acumular ráfagas
+    }
+
+    double elapsed = now_seconds() - start;
+    printf("Generador: %lu creadas (%.0f por minuto), %lu redimensionadas, %lu ocultadas/mostradas, %lu destruidas\n",
+           created, elapsed > 0 ? created * 60.0 / elapsed : 0.0, resized, toggled, destroyed);
+    XFreeGC(dpy, gc);
+    XCloseDisplay(dpy);
+    return 0;
+}
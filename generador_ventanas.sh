@@ -0,0 +1,5 @@
+#!/bin/sh
+
+n=generador_ventanas
+rm ./$n
+g++ $n.cpp -o $n -lX11
@@ -5,18 +5,53 @@
 #include <vector>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include "cache_instantaneas.h"
+#include "sonda_latencia.h"
 
 Display* x_display = nullptr;
 Window g_textureWindow; // ventana activa a mostrar
 GLuint g_textureID = 0;
 int g_textureWidth = 0, g_textureHeight = 0;
 std::vector<Window> windows; // lista de ventanas para cambiar
+int g_selected = 0;
+std::vector<unsigned char> g_pixels; // último frame convertido de la ventana activa
+bool g_textureNeedsInit = false;     // cambió el tamaño: hace falta glTexImage2D
+
+// instantáneas comprimidas de las ventanas no seleccionadas (--cache-mb)
+SnapshotCache* g_snapshots = nullptr;
+SnapshotCompressor* g_compressor = nullptr; // comprime fuera del hilo de GL
+bool g_skipCapture = false;          // este frame muestra la instantánea
+bool g_switchPending = false;
+bool g_switchFromCache = false;
+uint64_t g_switchStart = 0;
+LatencyHistogram g_switchCached("cache");
+LatencyHistogram g_switchCold("frio");
+
+void uploadTexture(const unsigned char* pixels, int width, int height, bool init) {
+    glBindTexture(GL_TEXTURE_2D, g_textureID);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    if (init) {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0,
+                     GL_RGB, GL_UNSIGNED_BYTE, pixels);
+    } else {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height,
+                        GL_RGB, GL_UNSIGNED_BYTE, pixels);
+    }
+}
 
-void captureWindowAsTexture(Window window, int width, int height, bool init) {
+// Devuelve false si no se pudo capturar (la textura queda como estaba).
+bool captureWindowAsTexture(Window window, int width, int height, bool init) {
     XImage* image = XGetImage(x_display, window, 0, 0, width, height, AllPlanes, ZPixmap);
-    if (!image) return;
+    if (!image) return false;
 
-    unsigned char* pixels = new unsigned char[width * height * 3];
+    g_pixels.resize((size_t)width * height * 3);
+    unsigned char* pixels = g_pixels.data();
 
     unsigned long red_mask = image->red_mask;
     unsigned long green_mask = image->green_mask;
@@ -39,27 +74,21 @@ void captureWindowAsTexture(Window window, int width, int height, bool init) {
         }
     }
 
-    glBindTexture(GL_TEXTURE_2D, g_textureID);
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-
-    if (init) {
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0,
-                     GL_RGB, GL_UNSIGNED_BYTE, pixels);
-    } else {
-        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height,
-                        GL_RGB, GL_UNSIGNED_BYTE, pixels);
-    }
-
-    delete[] pixels;
+    uploadTexture(pixels, width, height, init);
     XDestroyImage(image);
+    return true;
 }
 
 void display() {
-    captureWindowAsTexture(g_textureWindow, g_textureWidth, g_textureHeight, false);
+    bool live = !g_skipCapture;
+    // sin captura en vivo se muestra la instantánea que selectWindow ya subió
+    bool uploaded = !live;
+    // hasta que una captura en vivo se suba bien, la textura no tiene el tamaño nuevo
+    if (live && captureWindowAsTexture(g_textureWindow, g_textureWidth, g_textureHeight, g_textureNeedsInit)) {
+        g_textureNeedsInit = false;
+        uploaded = true;
+    }
+    g_skipCapture = false;
 
     glClear(GL_COLOR_BUFFER_BIT);
     glEnable(GL_TEXTURE_2D);
@@ -73,14 +102,68 @@ void display() {
     glEnd();
 
     glutSwapBuffers();
+
+    if (g_switchPending && uploaded) {
+        glFinish();
+        double ms = (probe_now_us() - g_switchStart) / 1000.0;
+        (g_switchFromCache ? g_switchCached : g_switchCold).add(ms);
+        printf("Primer pixel en %.2f ms (%s)\n", ms, g_switchFromCache ? "instantánea" : "en vivo");
+        g_switchPending = false;
+    }
+
     glutPostRedisplay();
 }
 
+void selectWindow(int idx) {
+    XWindowAttributes attr;
+    if (!XGetWindowAttributes(x_display, windows[idx], &attr) || attr.width <= 0 || attr.height <= 0)
+        return;
+
+    // el último frame de la ventana que se deja pasa a la cola de compresión
+    if (!g_skipCapture && !g_pixels.empty())
+        g_compressor->queue(g_textureWindow, g_textureWidth, g_textureHeight, g_pixels);
+
+    g_selected = idx;
+    g_textureWindow = windows[idx];
+    g_textureWidth = attr.width;
+    g_textureHeight = attr.height;
+    g_textureNeedsInit = true;
+    g_skipCapture = false;
+    g_switchFromCache = false;
+    g_switchPending = true;
+    g_switchStart = probe_now_us();
+
+    std::lock_guard<std::mutex> lock(g_compressor->lock);
+    const Snapshot* snap = g_snapshots->find(g_textureWindow);
+    if (snap && snap->width == g_textureWidth && snap->height == g_textureHeight) {
+        g_pixels.resize((size_t)snap->width * snap->height * 3);
+        if (snapshot_decompress(snap->data, g_pixels.data(), (size_t)snap->width * snap->height)) {
+            uploadTexture(g_pixels.data(), snap->width, snap->height, true);
+            g_textureNeedsInit = false;
+            g_skipCapture = true;
+            g_switchFromCache = true;
+        }
+    }
+    if (!g_switchFromCache) g_pixels.clear();
+}
+
 // función para cambiar ventana según tecla
 void keyboard(unsigned char key, int x, int y) {
-    if (key >= '0' && key - '0' < windows.size()) {
-        g_textureWindow = windows[key - '0'];
+    if (key >= '0' && key - '0' < (int)windows.size()) {
+        if (key - '0' == g_selected) return;
+        selectWindow(key - '0');
         printf("Ventana seleccionada: %d\n", key - '0');
+    } else if (key == 27) { // ESC
+        if (!g_switchCached.samples.empty() || !g_switchCold.samples.empty()) {
+            std::lock_guard<std::mutex> lock(g_compressor->lock);
+            printf("Cambio de ventana hasta el primer pixel (caché: %zu instantáneas, %.1f MB):\n",
+                   g_snapshots->count(), g_snapshots->bytes_used() / (1024.0 * 1024.0));
+            g_switchCached.report(stdout);
+            g_switchCold.report(stdout);
+        }
+        glDeleteTextures(1, &g_textureID);
+        XCloseDisplay(x_display);
+        exit(0);
     }
 }
 
@@ -117,6 +200,20 @@ int main(int argc, char** argv) {
 	}
 
     glutInit(&argc, argv);
+
+    int cacheMB = 256;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--cache-mb") && i + 1 < argc) {
+            cacheMB = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "Opción desconocida: %s\n"
+                    "Uso: %s [--cache-mb N]\n", argv[i], argv[0]);
+            return 1;
+        }
+    }
+    g_snapshots = new SnapshotCache((size_t)cacheMB * 1024 * 1024);
+    g_compressor = new SnapshotCompressor(g_snapshots);
+
     glutInitDisplayMode(GLUT_RGBA | GLUT_DOUBLE);
     glutInitWindowSize(g_textureWidth, g_textureHeight);
     glutCreateWindow("Captura X11 con cambio de ventana");
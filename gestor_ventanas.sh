@@ -2,7 +2,7 @@
 
 n=gestor_ventanas
 rm ./$n
-g++ $n.cpp -o $n -lXcomposite -lXrender -lglut -lGL -lGLU -lX11 -lXext -lXtst
+g++ $n.cpp -o $n -lXcomposite -lXrender -lglut -lGL -lGLU -lX11 -lXext -lXtst -pthread
 if [[ -f ./$n ]];then
 	cp -vf ./$n /bin
 	$n
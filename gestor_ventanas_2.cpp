@@ -1,26 +1,111 @@
-﻿#include <X11/Xlib.h>
+﻿#define GL_GLEXT_PROTOTYPES // FBO y PBO del modo --sin-pantalla
+#include <X11/Xlib.h>
 #include <X11/Xutil.h>
 #include <GL/gl.h>
 #include <GL/glu.h>
 #include <GL/glut.h>
 #include <GL/freeglut.h>
+#include <GL/glx.h>
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <poll.h>
+#include <unistd.h>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include "conversion_pixeles.h"
+#include "sonda_latencia.h"
+#include "prediccion_cambios.h"
+#include "estado_ventanas.h"
+#include "salida_sin_pantalla.h"
 
-struct WindowInfo {
+// Formato del frame completo: en BGRA tal como viene del servidor cuando se puede,
+// si no en RGB. Las miniaturas van siempre en RGB reducido.
+enum FrameKind { FRAME_FULL_BGRA, FRAME_FULL_RGB };
+
+// Ventana registrada por el hilo de captura de su display. Los campos marcados se
+// comparten con el hilo principal y se protegen con DisplaySource::m.
+struct CaptureSlot {
     Window xid;
     std::string title;
-    GLuint tex;
+    bool wanted = false;             // compartido: la pide el hilo principal (visible en pantalla)
+    int priority = 0;                // compartido: 2 seleccionada, 1 bajo el puntero, 0 el resto
+    bool warm = false;               // compartido: probable, completa a baja frecuencia
+    CaptureGate gate;                // solo el hilo de captura: estado y geometría por eventos
+    bool capturable = false;         // compartido
+
+    // frame completo (vista principal), compartido
+    double capturedAt = 0.0;         // cuándo se capturó 'frame' (seconds_now)
+    bool ready = false;              // hay un frame nuevo sin subir
+    int width = 0, height = 0;
+    int kind = FRAME_FULL_RGB;
+    std::vector<unsigned char> frame; // ya volteado, listo para glTexImage2D
+
+    // miniatura, compartido
+    double thumbAt = 0.0;
+    bool thumbReady = false;
+    int thumbWidth = 0, thumbHeight = 0;
+    std::vector<unsigned char> thumbFrame;
+};
+
+// Una conexión X con su registro de ventanas y su hilo de captura.
+struct DisplaySource {
+    std::string name;
+    Display* dpy = nullptr;
+    Window root = 0;
+    std::thread thread;
+
+    std::mutex m;
+    std::vector<std::shared_ptr<CaptureSlot>> slots; // protegido por m
+    unsigned long version = 0;                       // protegido por m; cambia con el registro
+    int thumbW = 0, thumbH = 0;                      // protegido por m; tamaño de miniatura en pantalla
+
+    WarmBudget budget{0.10};                         // solo lo usa el hilo de captura
+    std::map<Window, std::shared_ptr<CaptureSlot>> byXid; // solo el hilo de captura
+    std::atomic<int> byXidSize{0};                   // byXid.size(), para el modo resistencia
+    bool hostsGlut = false;                          // es el display de la ventana GLUT; fijo antes del hilo
+    std::atomic<Window> ownFrame{0};                 // lo fija el hilo de captura: marco de la ventana propia
+
+    std::atomic<bool> dead{false};
+    std::atomic<unsigned long> frames{0};
+    std::atomic<unsigned long> failures{0};
+    std::atomic<unsigned long> gated{0};             // capturas evitadas por el estado de la ventana
+    std::vector<double> passMs;                      // protegido por m; solo en modo resistencia
+};
+
+struct WindowInfo {
+    DisplaySource* src;
+    std::shared_ptr<CaptureSlot> slot;
+    std::string title;
+    GLuint tex;        // vista principal: la seleccionada y las que se traen por adelantado
     int texW, texH;
+    GLuint thumbTex;   // miniatura reducida con mipmaps
+    size_t texBytes, thumbBytes; // memoria estimada de cada textura
     bool capturable;
+    bool prefetch;     // precalentada o bajo el puntero: 'tex' se sube antes de elegirla
+    double frameTime;  // cuándo se capturó el frame subido a 'tex'
+};
+
+// Memoria y bytes subidos por rol de textura.
+struct TextureRole {
+    const char* name;
+    unsigned long uploads;
+    size_t uploadBytes;
 };
+TextureRole g_roleMain = { "principal", 0, 0 };
+TextureRole g_roleThumb = { "miniatura", 0, 0 };
+const int THUMB_DOWNSCALE_FACTOR = 2; // se reduce en CPU si la ventana es al menos 2x la miniatura
 
-Display* x_display = nullptr;
-Window x_root = 0;
+std::vector<DisplaySource*> g_sources;
+Window g_ownWindow = 0; // ventana GLUT propia; se fija antes de arrancar los hilos de captura
+std::vector<unsigned long> g_sourceVersions; // última versión de cada registro vista por el hilo principal
 std::vector<WindowInfo> g_windows;
 int g_selectedIndex = -1;
 
@@ -28,25 +113,108 @@ int winW = 1280;
 int winH = 720;
 const float PANEL_RATIO = 0.12f;
 const int GRID_ROWS = 1;
+const int MIN_THUMB_PX = 160;    // ancho mínimo de cada miniatura, en píxeles
+int g_stripFirst = 0;            // índice de la primera miniatura visible
 bool isFullscreen = true;
 
+const int CAPTURE_INTERVAL_MS = 16; // período mínimo entre pasadas de captura de cada display
+const int IDLE_INTERVAL_MS = 50;    // espera cuando no se pide ninguna ventana
+
+ThreadPool* g_pool = nullptr;    // conversión por bandas (--hilos N), solo con un display
+std::vector<unsigned char> g_uploadFrame; // frame que se sube; se intercambia con el del slot
+std::vector<unsigned char> g_uploadThumb; // ídem para la miniatura
+double g_startTime = 0.0;
+
+// ---------------- Precalentamiento (--precalentar K) ----------------
+// Las K ventanas más probables después de la seleccionada se capturan a resolución
+// completa aunque no estén en la tira, a baja frecuencia y dentro del presupuesto de
+// CPU de cada display, y su textura principal se sube antes de elegirlas. La ventana
+// bajo el puntero va primero y se captura completa cuando ese presupuesto lo permite
+// (y se le cobra); si no, solo su miniatura.
+SwitchPredictor<CaptureSlot*> g_predictor;
+int g_warmK = 2;
+double g_warmShare = 0.10;          // --presupuesto-cpu PCT
+const double WARM_REFRESH_S = 1.0;  // período de refresco de las precalentadas
+std::shared_ptr<CaptureSlot> g_hoverSlot; // la miniatura bajo el puntero, o nada
+
+bool g_switchPending = false;       // cambio de ventana sin primer pixel en pantalla
+bool g_switchLivePending = false;   // cambio de ventana sin frame capturado después del cambio
+double g_switchStart = 0.0;
+LatencyHistogram g_switchWarm("precal.");
+LatencyHistogram g_switchCold("frio");
+LatencyHistogram g_switchLive("en vivo");
+LatencyHistogram* g_switchHist = nullptr;
+
+// ---------------- Modo sin pantalla (--sin-pantalla) ----------------
+// La vista compuesta se dibuja a un framebuffer fuera de pantalla a ritmo fijo y se
+// escribe como secuencia PPM (--salida DIR) o flujo RGB crudo (--salida-cruda ARCHIVO).
+bool g_headless = false;
+OffscreenOutput g_output;
+double g_headlessFps = 10.0;
+double g_headlessNext = 0.0;       // momento del próximo cuadro (seconds_now)
+long g_headlessFrames = 0;
+long g_headlessMaxFrames = 0;      // --cuadros N, 0 = sin límite
+unsigned long g_headlessLate = 0;  // cuadros que no llegaron a tiempo
+double g_headlessDrawTime = 0.0;
+
+// ---------------- Modo resistencia (--resistencia) ----------------
+// Cada segundo se anotan texturas vivas (en total y por rol), el tamaño de los registros
+// (slots y byXid de cada display, g_windows), XImages sin destruir, RSS y tiempo de cada
+// pasada de captura; al terminar se falla si alguno siguió creciendo o si quedó una
+// textura sin ventana.
+struct SoakSample {
+    double t;
+    int textures;                  // todas las creadas con create_texture() y no borradas
+    int mainTextures, thumbTextures; // las que cuelgan de g_windows, por rol
+    int slots, byXid;              // entradas de los registros de todos los displays
+    int windows;                   // g_windows.size()
+    long images;                   // XImages vivas; sana, 0 (o las de una captura en curso)
+    long rssKB;
+    double captureP50, captureP99; // ms por pasada de captura en el último segundo
+};
+
+bool g_soak = false;
+const char* g_soakFile = "resistencia.txt";
+double g_soakDuration = 60.0;          // segundos
+FILE* g_soakOut = nullptr;
+std::vector<SoakSample> g_soakSamples;
+int g_liveTextures = 0;                // solo el hilo principal
+std::atomic<long> g_liveImages{0};     // XImages de XGetImage sin XDestroyImage, todos los hilos
+
 // ---------------- Manejo de errores X ----------------
-static int trapped_error_code = 0;
+// Cada display se usa desde un único hilo, así que la trampa es por hilo; el
+// manejador se instala una sola vez porque XSetErrorHandler es global al proceso.
+static thread_local int trapped_error_code = 0;
+static thread_local bool trapping = false;
 
 int x_error_handler(Display*, XErrorEvent* error) {
-    trapped_error_code = error->error_code;
+    if (trapping) trapped_error_code = error->error_code;
+    else fprintf(stderr, "Error X no atrapado: código %d\n", error->error_code);
     return 0;
 }
 
-void start_xerror_trap() {
+// Sin salir del proceso: la salida la decide el manejador por display.
+int x_io_error_handler(Display*) {
+    return 0;
+}
+
+// Un display caído marca su fuente como muerta en vez de terminar el proceso;
+// Xlib deja la conexión inutilizable y las llamadas siguientes fallan enseguida.
+void x_io_exit_handler(Display*, void* data) {
+    DisplaySource* s = static_cast<DisplaySource*>(data);
+    if (!s->dead.exchange(true))
+        fprintf(stderr, "Display %s: conexión perdida, se deja de capturar\n", s->name.c_str());
+}
+
+void start_xerror_trap(Display* dpy) {
     trapped_error_code = 0;
-    XSync(x_display, False);
-    XSetErrorHandler(x_error_handler);
+    XSync(dpy, False);
+    trapping = true;
 }
 
-bool end_xerror_trap() {
-    XSync(x_display, False);
-    XSetErrorHandler(nullptr);
+bool end_xerror_trap(Display* dpy) {
+    XSync(dpy, False);
+    trapping = false;
     return trapped_error_code != 0;
 }
 
@@ -76,99 +244,576 @@ static std::string get_window_title(Display* dpy, Window w) {
     return "[Sin título]";
 }
 
-void enumerate_windows() {
-    g_windows.clear();
+// ---------------- Registro por display ----------------
+// Todo corre en el hilo de captura del display; el lock solo cubre la lista compartida.
+
+// La ventana del gestor (o el marco con que la envolvió el gestor de ventanas) no se
+// registra: capturarla mostraría la propia vista dentro de sí misma. Solo en el display
+// de GLUT: los XID se asignan por servidor y en otro pueden ser de una ventana real.
+static bool is_own_window(DisplaySource* s, Window w) {
+    return s->hostsGlut && (w == g_ownWindow || (s->ownFrame && w == s->ownFrame));
+}
+
+// Si la ventana propia ya fue enmarcada antes de suscribirse a la raíz, busca el marco.
+static void find_own_frame(DisplaySource* s) {
+    if (!s->hostsGlut || !g_ownWindow) return;
+    Window cur = g_ownWindow;
+    start_xerror_trap(s->dpy);
+    for (int depth = 0; depth < 8; ++depth) {
+        Window root_return, parent = 0;
+        Window* children = nullptr;
+        unsigned int nchildren = 0;
+        if (!XQueryTree(s->dpy, cur, &root_return, &parent, &children, &nchildren)) break;
+        if (children) XFree(children);
+        if (parent == s->root || parent == 0) break;
+        cur = parent;
+    }
+    if (!end_xerror_trap(s->dpy) && cur != g_ownWindow) s->ownFrame = cur;
+}
+
+static void add_window(DisplaySource* s, Window w, const XWindowAttributes &attr) {
+    if (is_own_window(s, w)) return;
+    auto slot = std::make_shared<CaptureSlot>();
+    slot->xid = w;
+    slot->title = get_window_title(s->dpy, w);
+    gate_init(s->dpy, w, attr, slot->gate);
+    s->byXid[w] = slot;
+    s->byXidSize = s->byXid.size();
+
+    std::lock_guard<std::mutex> lock(s->m);
+    s->slots.push_back(slot);
+    ++s->version;
+}
+
+static void remove_window(DisplaySource* s, Window w) {
+    auto it = s->byXid.find(w);
+    if (it == s->byXid.end()) return;
+    std::shared_ptr<CaptureSlot> slot = it->second;
+    s->byXid.erase(it);
+    s->byXidSize = s->byXid.size();
+
+    std::lock_guard<std::mutex> lock(s->m);
+    s->slots.erase(std::remove(s->slots.begin(), s->slots.end(), slot), s->slots.end());
+    ++s->version;
+}
+
+// Llena el registro de 's'. La raíz se suscribe antes de listar para no perder
+// ventanas que aparezcan en el medio.
+static void enumerate_windows(DisplaySource* s) {
+    XSelectInput(s->dpy, s->root, SubstructureNotifyMask);
+    find_own_frame(s);
+
     Window root_return, parent_return;
     Window* children = nullptr;
     unsigned int nchildren = 0;
 
-    if (!XQueryTree(x_display, x_root, &root_return, &parent_return, &children, &nchildren)) {
+    if (!XQueryTree(s->dpy, s->root, &root_return, &parent_return, &children, &nchildren)) {
         if (children) XFree(children);
         return;
     }
 
+    start_xerror_trap(s->dpy);
     for (unsigned int i = 0; i < nchildren; ++i) {
         Window w = children[i];
-        WindowInfo info{};
-        info.xid = w;
-        info.title = get_window_title(x_display, w);
-        info.tex = 0;
-        info.texW = info.texH = 0;
-        info.capturable = false;
-        g_windows.push_back(info);
+        XWindowAttributes attr;
+        if (!XGetWindowAttributes(s->dpy, w, &attr)) continue;
+        if (attr.map_state != IsViewable) continue; // solo ventanas visibles
+        if (attr.width <= 0 || attr.height <= 0) continue;
+        add_window(s, w, attr);
     }
+    end_xerror_trap(s->dpy);
     if (children) XFree(children);
 }
 
-// ---------------- Captura segura ----------------
-static void ensure_texture(WindowInfo &info) {
-    XWindowAttributes wa;
-    if (!XGetWindowAttributes(x_display, info.xid, &wa)) {
-        info.capturable = false;
-        return;
+// Atiende los eventos pendientes: altas y bajas del registro y estado de cada ventana.
+static void process_events(DisplaySource* s) {
+    while (!s->dead && XPending(s->dpy)) {
+        XEvent ev;
+        XNextEvent(s->dpy, &ev);
+        Window w = gate_event_window(ev);
+
+        if (ev.type == MapNotify && ev.xmap.event == s->root && !s->byXid.count(w)) {
+            XWindowAttributes attr;
+            start_xerror_trap(s->dpy);
+            if (XGetWindowAttributes(s->dpy, w, &attr)) add_window(s, w, attr);
+            if (end_xerror_trap(s->dpy)) remove_window(s, w); // se destruyó en el medio
+        } else if (ev.type == DestroyNotify && ev.xdestroywindow.event == s->root) {
+            remove_window(s, w);
+        } else if (ev.type == ReparentNotify && ev.xreparent.event == s->root && ev.xreparent.parent != s->root) {
+            remove_window(s, ev.xreparent.window); // la enmarcó el gestor de ventanas; queda el marco
+            if (s->hostsGlut && ev.xreparent.window == g_ownWindow) {
+                s->ownFrame = ev.xreparent.parent;
+                remove_window(s, s->ownFrame);
+            }
+        } else {
+            auto it = s->byXid.find(w);
+            if (it != s->byXid.end()) gate_update(s->dpy, ev, it->second->gate);
+        }
+    }
+}
+
+// Espera hasta 'until' atendiendo eventos apenas llegan.
+static void wait_events(DisplaySource* s, std::chrono::steady_clock::time_point until) {
+    for (;;) {
+        process_events(s);
+        if (s->dead) return;
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(until - std::chrono::steady_clock::now());
+        if (left.count() <= 0) return;
+        struct pollfd pfd = { ConnectionNumber(s->dpy), POLLIN, 0 };
+        if (poll(&pfd, 1, (int)left.count()) <= 0) return;
     }
+}
 
-    info.capturable = (wa.width > 0 && wa.height > 0);
-    if (!info.capturable) return;
+// ---------------- Captura por display ----------------
+// Captura y convierte fuera del lock; solo el intercambio del frame se hace con el lock tomado.
+// La geometría sale de ConfigureNotify: no hay ida y vuelta previa al servidor.
+// 'full' captura para la vista principal; si no, como miniatura. Devuelve false si falló.
+static bool capture_slot(DisplaySource* s, CaptureSlot &slot, bool full, std::vector<unsigned char> &back,
+                         std::vector<unsigned char> &scratch, ThreadPool* pool) {
+    int thumbW, thumbH;
+    {
+        std::lock_guard<std::mutex> lock(s->m);
+        thumbW = s->thumbW;
+        thumbH = s->thumbH;
+    }
 
-    start_xerror_trap();
-    XImage* img = XGetImage(x_display, info.xid, 0, 0, wa.width, wa.height, AllPlanes, ZPixmap);
-    bool failed = end_xerror_trap();
+    int width = slot.gate.width;
+    int height = slot.gate.height;
+    start_xerror_trap(s->dpy);
+    XImage* img = XGetImage(s->dpy, slot.xid, 0, 0, width, height, AllPlanes, ZPixmap);
+    bool ok = !end_xerror_trap(s->dpy) && img;
+    if (img) g_liveImages++;
 
-    if (failed || !img) {
-        info.capturable = false;
-        return;
+    int kind = FRAME_FULL_RGB;
+    if (ok && full && image_is_native_bgra(img)) {
+        back.resize((size_t)width * height * 4);
+        copy_rows_bgra(img, back.data());
+        kind = FRAME_FULL_BGRA;
+    } else if (ok) {
+        back.resize((size_t)width * height * 3);
+        // Conversión a RGB con flip vertical (ty = height - 1 - y), por bandas de filas
+        // en el pool de hilos cuando la ventana es grande.
+        convert_image_rgb(img, back.data(), pool);
+
+        // miniatura mucho más chica que la ventana: se reduce acá y se sube menos;
+        // por debajo del factor alcanza con los mipmaps
+        if (!full && thumbW > 0 && thumbH > 0 &&
+            (width >= THUMB_DOWNSCALE_FACTOR * thumbW || height >= THUMB_DOWNSCALE_FACTOR * thumbH)) {
+            int dw = thumbW < width ? thumbW : width;
+            int dh = thumbH < height ? thumbH : height;
+            scratch.resize((size_t)dw * dh * 3);
+            downscale_box_rgb(back.data(), width, height, scratch.data(), dw, dh);
+            back.swap(scratch);
+            width = dw;
+            height = dh;
+        }
+    }
+    if (img) {
+        XDestroyImage(img);
+        g_liveImages--;
     }
 
-    int width = wa.width;
-    int height = wa.height;
-    unsigned char* pixels = new unsigned char[width * height * 3];
-
-    unsigned long rmask = img->red_mask;
-    unsigned long gmask = img->green_mask;
-    unsigned long bmask = img->blue_mask;
-    int rshift = 0; while (!((rmask >> rshift) & 1) && rshift < 32) rshift++;
-    int gshift = 0; while (!((gmask >> gshift) & 1) && gshift < 32) gshift++;
-    int bshift = 0; while (!((bmask >> bshift) & 1) && bshift < 32) bshift++;
-
-    // Conversión y corrección de color (Aseguramos RGB correcto)
-    // Nota: mantenemos el flip vertical (ty = height - 1 - y) para que la textura se vea con orientación correcta.
-    for (int y = 0; y < height; ++y) {
-        int ty = height - 1 - y;
-        for (int x = 0; x < width; ++x) {
-            unsigned long p = XGetPixel(img, x, y);
-            unsigned char r = ((p & rmask) >> rshift) & 0xFF;
-            unsigned char g = ((p & gmask) >> gshift) & 0xFF;
-            unsigned char b = ((p & bmask) >> bshift) & 0xFF;
-
-            int idx = (ty * width + x) * 3;
-            // ---> CORRECCIÓN: escribir en orden R, G, B (sin intercambio)
-            pixels[idx]     = r;
-            pixels[idx + 1] = g;
-            pixels[idx + 2] = b;
+    if (!ok && (trapped_error_code == BadWindow || trapped_error_code == BadDrawable)) {
+        // se destruyó entre la enumeración y la captura: se suelta ya, sin esperar a
+        // su DestroyNotify, para no volver a caer en la trampa en cada pasada
+        s->failures++;
+        remove_window(s, slot.xid);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(s->m);
+    slot.capturable = ok;
+    if (!ok) {
+        s->failures++;
+        return false;
+    }
+    if (full) {
+        slot.frame.swap(back);
+        slot.width = width;
+        slot.height = height;
+        slot.kind = kind;
+        slot.capturedAt = seconds_now();
+        slot.ready = true;
+    } else {
+        slot.thumbFrame.swap(back);
+        slot.thumbWidth = width;
+        slot.thumbHeight = height;
+        slot.thumbAt = seconds_now();
+        slot.thumbReady = true;
+    }
+    s->frames++;
+    return true;
+}
+
+// Cada display tiene su hilo: uno lento o caído solo retrasa sus propias ventanas.
+static void capture_loop(DisplaySource* s, ThreadPool* pool) {
+    enumerate_windows(s);
+
+    struct Job {
+        std::shared_ptr<CaptureSlot> slot;
+        int priority;
+        bool full, thumb;
+    };
+    std::vector<unsigned char> back, scratch;
+    std::vector<Job> todo;
+    while (!s->dead) {
+        auto next = std::chrono::steady_clock::now() + std::chrono::milliseconds(CAPTURE_INTERVAL_MS);
+
+        todo.clear();
+        std::shared_ptr<CaptureSlot> stalest;
+        {
+            std::lock_guard<std::mutex> lock(s->m);
+            double now = seconds_now();
+            for (auto &slot : s->slots) {
+                // sin mapear, minimizada o tapada: se difiere hasta que un evento la habilite
+                if (!slot->gate.can_capture()) {
+                    if (slot->wanted) s->gated++;
+                    continue;
+                }
+                // la seleccionada va completa y la que está bajo el puntero también si hay
+                // presupuesto; su miniatura se refresca aparte, a la frecuencia de las precalentadas
+                if (slot->wanted) {
+                    bool full = slot->priority > 1 || (slot->priority == 1 && s->budget.allowed(now));
+                    todo.push_back({ slot, slot->priority, full, !full || now - slot->thumbAt >= WARM_REFRESH_S });
+                }
+                if (slot->warm && slot->priority == 0 && (!stalest || slot->capturedAt < stalest->capturedAt))
+                    stalest = slot;
+            }
+            std::stable_sort(todo.begin(), todo.end(),
+                             [](const Job &a, const Job &b) { return a.priority > b.priority; });
+            if (stalest && (now - stalest->capturedAt < WARM_REFRESH_S || !s->budget.allowed(now)))
+                stalest.reset();
+        }
+        double passStart = seconds_now();
+        for (Job &job : todo) {
+            if (s->dead) break;
+            if (job.full) {
+                double t0 = seconds_now();
+                bool ok = capture_slot(s, *job.slot, true, back, scratch, pool);
+                if (job.priority == 1) s->budget.charge(t0, seconds_now());
+                if (!ok) continue;
+            }
+            if (job.thumb) capture_slot(s, *job.slot, false, back, scratch, pool);
+        }
+        if (g_soak && !todo.empty()) {
+            std::lock_guard<std::mutex> lock(s->m);
+            s->passMs.push_back((seconds_now() - passStart) * 1000.0);
+        }
+
+        // una precalentada por pasada como máximo, completa; el hilo principal la sube
+        // a su textura principal antes de que se elija
+        if (stalest && !s->dead && s->budget.allowed(seconds_now())) {
+            double t0 = seconds_now();
+            capture_slot(s, *stalest, true, back, scratch, pool);
+            s->budget.charge(t0, seconds_now());
+        }
+
+        if (todo.empty())
+            next = std::chrono::steady_clock::now() + std::chrono::milliseconds(IDLE_INTERVAL_MS);
+        wait_events(s, next);
+    }
+}
+
+// Nombre de display sin el número de pantalla (":1.0" -> ":1").
+static std::string display_server(const std::string &name) {
+    size_t colon = name.rfind(':');
+    size_t dot = name.find('.', colon == std::string::npos ? 0 : colon);
+    return dot == std::string::npos ? name : name.substr(0, dot);
+}
+
+// Se llama con la ventana GLUT ya creada, para que ningún hilo la registre.
+static void start_capture_threads() {
+    g_ownWindow = glXGetCurrentDrawable();
+    Display* glutDpy = glXGetCurrentDisplay();
+    std::string glutServer = glutDpy ? display_server(DisplayString(glutDpy)) : "";
+    for (DisplaySource* s : g_sources) {
+        s->hostsGlut = display_server(s->name) == glutServer;
+        s->thread = std::thread(capture_loop, s, g_pool);
+    }
+}
+
+static DisplaySource* open_source(const char* name) {
+    Display* dpy = XOpenDisplay(name);
+    if (!dpy) {
+        fprintf(stderr, "No se pudo abrir X display %s\n", name ? name : "(DISPLAY)");
+        return nullptr;
+    }
+    DisplaySource* s = new DisplaySource;
+    s->name = DisplayString(dpy);
+    s->dpy = dpy;
+    s->root = DefaultRootWindow(dpy);
+    s->budget = WarmBudget(g_warmShare);
+    XSetIOErrorExitHandler(dpy, x_io_exit_handler, s);
+    return s;
+}
+
+// ---------------- Texturas ----------------
+// Todas las texturas pasan por acá para llevar la cuenta de las vivas.
+static void create_texture(GLuint &tex) {
+    glGenTextures(1, &tex);
+    g_liveTextures++;
+}
+
+static void delete_texture(GLuint &tex) {
+    if (!tex) return;
+    glDeleteTextures(1, &tex);
+    tex = 0;
+    g_liveTextures--;
+}
+
+// ---------------- Registro combinado ----------------
+// Rehace g_windows cuando cambia el registro de algún display, conservando las
+// texturas y la selección de las ventanas que siguen existiendo.
+static void sync_windows() {
+    bool changed = false;
+    for (size_t i = 0; i < g_sources.size(); ++i) {
+        std::lock_guard<std::mutex> lock(g_sources[i]->m);
+        if (g_sources[i]->version != g_sourceVersions[i]) changed = true;
+    }
+    if (!changed) return;
+
+    std::shared_ptr<CaptureSlot> selected;
+    if (g_selectedIndex >= 0 && g_selectedIndex < (int)g_windows.size())
+        selected = g_windows[g_selectedIndex].slot;
+
+    std::vector<WindowInfo> old;
+    old.swap(g_windows);
+    for (size_t i = 0; i < g_sources.size(); ++i) {
+        DisplaySource* s = g_sources[i];
+        std::lock_guard<std::mutex> lock(s->m);
+        g_sourceVersions[i] = s->version;
+        for (auto &slot : s->slots) {
+            WindowInfo info{};
+            info.src = s;
+            info.slot = slot;
+            info.title = g_sources.size() > 1 ? s->name + " " + slot->title : slot->title;
+            info.tex = info.thumbTex = 0;
+            info.texW = info.texH = 0;
+            info.texBytes = info.thumbBytes = 0;
+            info.capturable = false;
+            for (auto &o : old) {
+                if (o.slot != slot) continue;
+                info = o;
+                info.title = g_sources.size() > 1 ? s->name + " " + slot->title : slot->title;
+                o.tex = o.thumbTex = 0;
+                o.slot.reset();
+                break;
+            }
+            g_windows.push_back(info);
+        }
+    }
+    for (auto &o : old) {
+        delete_texture(o.tex);
+        delete_texture(o.thumbTex);
+        if (o.slot) g_predictor.forget(o.slot.get());
+        if (o.slot && o.slot == g_hoverSlot) g_hoverSlot.reset();
+    }
+
+    g_selectedIndex = g_windows.empty() ? -1 : 0;
+    for (size_t i = 0; i < g_windows.size(); ++i)
+        if (g_windows[i].slot == selected) g_selectedIndex = i;
+}
+
+// Publica qué ventanas se ven (la seleccionada y las miniaturas de la tira visible),
+// en qué orden capturarlas, a qué tamaño reducir las miniaturas y cuáles precalentar.
+// Los hilos de captura solo capturan esas.
+static void publish_wanted(int first, int capacity, int thumbW, int thumbH) {
+    std::vector<CaptureSlot*> warm;
+    if (g_warmK > 0) {
+        std::vector<CaptureSlot*> ids;
+        for (auto &w : g_windows) ids.push_back(w.slot.get());
+        CaptureSlot* current = g_selectedIndex >= 0 ? g_windows[g_selectedIndex].slot.get() : nullptr;
+        warm = g_predictor.top_k(current, ids, g_warmK);
+    }
+
+    for (DisplaySource* s : g_sources) {
+        std::lock_guard<std::mutex> lock(s->m);
+        s->thumbW = thumbW;
+        s->thumbH = thumbH;
+        for (size_t i = 0; i < g_windows.size(); ++i) {
+            if (g_windows[i].src != s) continue;
+            int idx = i;
+            CaptureSlot* slot = g_windows[i].slot.get();
+            slot->wanted = idx == g_selectedIndex || (idx >= first && idx < first + capacity);
+            bool hover = slot == g_hoverSlot.get();
+            slot->priority = idx == g_selectedIndex ? 2 : hover ? 1 : 0;
+            slot->warm = std::find(warm.begin(), warm.end(), slot) != warm.end();
+            g_windows[i].prefetch = idx != g_selectedIndex && (slot->warm || hover);
         }
     }
+}
 
+// ---------------- Subida de texturas ----------------
+// Vista principal: resolución completa, GL_RGBA8 desde BGRA de 4 bytes alineado
+// (o GL_RGB8 si el servidor no da BGRA nativo), sin mipmaps.
+static void upload_main(WindowInfo &info, int kind, const unsigned char* pixels, int width, int height) {
     if (info.tex == 0)
-        glGenTextures(1, &info.tex);
+        create_texture(info.tex);
 
+    bool bgra = kind == FRAME_FULL_BGRA;
     glBindTexture(GL_TEXTURE_2D, info.tex);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0,
-                 GL_RGB, GL_UNSIGNED_BYTE, pixels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, bgra ? 4 : 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, bgra ? GL_RGBA8 : GL_RGB8, width, height, 0,
+                 bgra ? GL_BGRA : GL_RGB, GL_UNSIGNED_BYTE, pixels);
 
+    size_t bytes = (size_t)width * height * (bgra ? 4 : 3);
     info.texW = width;
     info.texH = height;
+    info.texBytes = (size_t)width * height * 4; // GL_RGB8 también ocupa 4 bytes por texel
+    g_roleMain.uploads++;
+    g_roleMain.uploadBytes += bytes;
+}
+
+// Miniatura: ya reducida en CPU si hacía falta, en 16 bits (GL_RGB5) y con mipmaps
+// para que la minificación no produzca aliasing.
+static void upload_thumb(WindowInfo &info, const unsigned char* pixels, int width, int height) {
+    if (info.thumbTex == 0)
+        create_texture(info.thumbTex);
+
+    glBindTexture(GL_TEXTURE_2D, info.thumbTex);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB5, width, height, 0,
+                 GL_RGB, GL_UNSIGNED_BYTE, pixels);
+    glGenerateMipmap(GL_TEXTURE_2D);
+
+    info.thumbBytes = (size_t)width * height * 2 * 4 / 3; // nivel base + cadena de mipmaps
+    g_roleThumb.uploads++;
+    g_roleThumb.uploadBytes += (size_t)width * height * 3;
+}
+
+// Sube los últimos frames capturados, si hay nuevos; nunca espera al hilo de captura.
+static void ensure_texture(WindowInfo &info, bool selected) {
+    int width = 0, height = 0, kind = 0, thumbWidth = 0, thumbHeight = 0;
+    double capturedAt = 0.0;
+    bool full = false, thumb = false;
+    {
+        std::lock_guard<std::mutex> lock(info.src->m);
+        CaptureSlot &slot = *info.slot;
+        info.capturable = slot.capturable;
+        if (slot.thumbReady) {
+            g_uploadThumb.swap(slot.thumbFrame);
+            thumbWidth = slot.thumbWidth;
+            thumbHeight = slot.thumbHeight;
+            slot.thumbReady = false;
+            thumb = true;
+        }
+        // un frame completo de una ventana que ya no se muestra ni se espera se descarta
+        if (slot.ready && (selected || info.prefetch)) {
+            g_uploadFrame.swap(slot.frame);
+            width = slot.width;
+            height = slot.height;
+            kind = slot.kind;
+            capturedAt = slot.capturedAt;
+            full = true;
+        }
+        slot.ready = false;
+    }
+
+    if (thumb)
+        upload_thumb(info, g_uploadThumb.data(), thumbWidth, thumbHeight);
+    if (full) {
+        upload_main(info, kind, g_uploadFrame.data(), width, height);
+        info.frameTime = capturedAt;
+    }
+}
+
+// Sube por adelantado la textura principal de las precalentadas y de la que está bajo
+// el puntero; las demás no seleccionadas la liberan.
+static void prefetch_main_textures() {
+    for (size_t i = 0; i < g_windows.size(); ++i) {
+        WindowInfo &wi = g_windows[i];
+        if ((int)i == g_selectedIndex) continue;
+        if (wi.prefetch) {
+            ensure_texture(wi, false);
+        } else if (wi.tex) {
+            delete_texture(wi.tex);
+            wi.texBytes = 0;
+        }
+    }
+}
+
+// Memoria residente y bytes subidos por rol.
+static void report_textures() {
+    size_t mainBytes = 0, thumbBytes = 0;
+    int mainCount = 0, thumbCount = 0;
+    for (auto &w : g_windows) {
+        if (w.tex) { mainBytes += w.texBytes; mainCount++; }
+        if (w.thumbTex) { thumbBytes += w.thumbBytes; thumbCount++; }
+    }
+    const TextureRole* roles[] = { &g_roleMain, &g_roleThumb };
+    size_t resident[] = { mainBytes, thumbBytes };
+    int counts[] = { mainCount, thumbCount };
+    for (int r = 0; r < 2; ++r)
+        printf("Texturas %-9s: %d residentes, %.1f MB; %lu subidas, %.1f MB subidos\n",
+               roles[r]->name, counts[r], resident[r] / (1024.0 * 1024.0),
+               roles[r]->uploads, roles[r]->uploadBytes / (1024.0 * 1024.0));
+}
+
+static void select_window(int idx) {
+    if (idx == g_selectedIndex) return;
+    if (g_selectedIndex >= 0 && g_selectedIndex < (int)g_windows.size())
+        g_predictor.record(g_windows[g_selectedIndex].slot.get(), g_windows[idx].slot.get());
+    // la textura principal de la que se deja la libera prefetch_main_textures() si no
+    // queda entre las precalentadas
+    g_selectedIndex = idx;
+
+    // precalentada: ya hay un frame completo subido y el primer pixel es inmediato; si
+    // no, se muestra la miniatura ampliada hasta que llega la captura completa
+    g_switchHist = g_windows[idx].tex ? &g_switchWarm : &g_switchCold;
+    g_switchPending = g_switchLivePending = true;
+    g_switchStart = seconds_now();
+}
+
+static void report_switches() {
+    if (g_switchWarm.samples.empty() && g_switchCold.samples.empty()) return;
+    printf("Cambio de ventana hasta el primer pixel (precalentamiento K=%d):\n", g_warmK);
+    g_switchWarm.report(stdout);
+    g_switchCold.report(stdout);
+    g_switchLive.report(stdout);
+}
+
+// Cuadros capturados por display desde el arranque.
+static void report_sources() {
+    double secs = seconds_now() - g_startTime;
+    for (DisplaySource* s : g_sources)
+        printf("Display %s: %lu ventanas capturadas (%.1f/s), %lu fallos, %lu evitadas%s\n",
+               s->name.c_str(), (unsigned long)s->frames, secs > 0 ? s->frames / secs : 0.0,
+               (unsigned long)s->failures, (unsigned long)s->gated, s->dead ? ", conexión perdida" : "");
+}
+
+// ---------------- Tira de miniaturas ----------------
+// La tira es virtual: solo las miniaturas que entran en pantalla se capturan y dibujan.
+static int strip_columns() {
+    int total = g_windows.size();
+    int fit = winW / MIN_THUMB_PX;
+    int needed = (total + GRID_ROWS - 1) / GRID_ROWS;
+    int cols = needed < fit ? needed : fit;
+    return cols < 1 ? 1 : cols;
+}
+
+static int strip_capacity() {
+    return strip_columns() * GRID_ROWS;
+}
 
-    delete[] pixels;
-    XDestroyImage(img);
+static void clamp_strip() {
+    int maxFirst = (int)g_windows.size() - strip_capacity();
+    if (g_stripFirst > maxFirst) g_stripFirst = maxFirst;
+    if (g_stripFirst < 0) g_stripFirst = 0;
+}
+
+static void scroll_strip(int delta) {
+    g_stripFirst += delta;
+    clamp_strip();
 }
 
 // ---------------- Dibujo ----------------
 static void drawTexturedQuad(GLuint tex, float x1, float y1, float x2, float y2) {
     if (tex == 0) return;
+    glColor3f(1.0f,1.0f,1.0f); // sin teñir con el color del panel o de los marcadores
     glBindTexture(GL_TEXTURE_2D, tex);
     glBegin(GL_QUADS);
         glTexCoord2f(0, 0); glVertex2f(x1, y1);
@@ -178,7 +823,8 @@ static void drawTexturedQuad(GLuint tex, float x1, float y1, float x2, float y2)
     glEnd();
 }
 
-void display() {
+// Dibuja la vista compuesta (ventana seleccionada y tira); false si no hay ventanas.
+static bool draw_scene() {
     glClearColor(0,0,0,1);
     glClear(GL_COLOR_BUFFER_BIT);
     glEnable(GL_TEXTURE_2D);
@@ -186,6 +832,12 @@ void display() {
     float panelH = PANEL_RATIO;
     float panelTopY = -1.0f + 2.0f * panelH;
 
+    sync_windows();
+    clamp_strip();
+    publish_wanted(g_stripFirst, strip_capacity(),
+                   winW / strip_columns(), (int)(winH * PANEL_RATIO / GRID_ROWS));
+    prefetch_main_textures();
+
     if (g_windows.empty()) {
         glDisable(GL_TEXTURE_2D);
         glColor3f(0.4f,0.4f,0.4f);
@@ -195,15 +847,16 @@ void display() {
             glVertex2f(0.8f,0.05f);
             glVertex2f(-0.8f,0.05f);
         glEnd();
-        glutSwapBuffers();
-        return;
+        glEnable(GL_TEXTURE_2D);
+        return false;
     }
 
     if (g_selectedIndex >= 0 && g_selectedIndex < (int)g_windows.size()) {
         WindowInfo &sel = g_windows[g_selectedIndex];
-        ensure_texture(sel);
-        if (sel.capturable && sel.tex)
-            drawTexturedQuad(sel.tex, -1.0f, panelTopY, 1.0f, 1.0f);
+        ensure_texture(sel, true);
+        GLuint tex = sel.tex ? sel.tex : sel.thumbTex; // recién elegida: la miniatura ampliada
+        if (sel.capturable && tex)
+            drawTexturedQuad(tex, -1.0f, panelTopY, 1.0f, 1.0f);
         else {
             glDisable(GL_TEXTURE_2D);
             glColor3f(0.25f,0.25f,0.25f);
@@ -229,11 +882,11 @@ void display() {
 
     int total = g_windows.size();
     int rows = GRID_ROWS;
-    int cols = (total + rows - 1) / rows;
+    int cols = strip_columns();
     float thumbW = 2.0f / cols;
     float thumbH = (2.0f * panelH) / rows;
 
-    int idx = 0;
+    int idx = g_stripFirst;
     for (int row = 0; row < rows; ++row) {
         for (int col = 0; col < cols; ++col) {
             if (idx >= total) break;
@@ -243,10 +896,13 @@ void display() {
             float y_bottom = y_top - thumbH;
 
             WindowInfo &wi = g_windows[idx];
-            ensure_texture(wi);
+            bool selected = idx == g_selectedIndex;
+            if (!selected) ensure_texture(wi, false);
 
-            if (wi.capturable && wi.tex)
-                drawTexturedQuad(wi.tex, x1, y_bottom, x2, y_top);
+            // siempre la miniatura con mipmaps, también para la seleccionada: la textura
+            // principal no tiene mipmaps y reducida así produce aliasing
+            if (wi.capturable && wi.thumbTex)
+                drawTexturedQuad(wi.thumbTex, x1, y_bottom, x2, y_top);
             else {
                 glDisable(GL_TEXTURE_2D);
                 glColor3f(idx == g_selectedIndex ? 0.5f : 1.0f, 1.0f, 1.0f);
@@ -262,10 +918,225 @@ void display() {
         }
     }
 
+    // indicador de desplazamiento cuando no entran todas
+    int capacity = strip_capacity();
+    if (total > capacity) {
+        float bx1 = -1.0f + 2.0f * g_stripFirst / total;
+        float bx2 = -1.0f + 2.0f * (g_stripFirst + capacity) / total;
+        glDisable(GL_TEXTURE_2D);
+        glColor3f(0.6f,0.6f,0.6f);
+        glBegin(GL_QUADS);
+            glVertex2f(bx1, -1.0f);
+            glVertex2f(bx2, -1.0f);
+            glVertex2f(bx2, -0.99f);
+            glVertex2f(bx1, -0.99f);
+        glEnd();
+        glEnable(GL_TEXTURE_2D);
+    }
+    return true;
+}
+
+void display() {
+    bool drawn = draw_scene();
     glutSwapBuffers();
+
+    if (drawn && (g_switchPending || g_switchLivePending)) {
+        WindowInfo &sel = g_windows[g_selectedIndex];
+        bool shown = sel.tex || sel.thumbTex;
+        bool live = sel.tex && sel.frameTime >= g_switchStart;
+        if ((g_switchPending && shown) || (g_switchLivePending && live)) {
+            glFinish();
+            double ms = (seconds_now() - g_switchStart) * 1000.0;
+            if (g_switchPending && shown) {
+                g_switchHist->add(ms);
+                g_switchPending = false;
+            }
+            if (g_switchLivePending && live) {
+                g_switchLive.add(ms);
+                g_switchLivePending = false;
+            }
+        }
+    }
     glutPostRedisplay();
 }
 
+// ---------------- Dibujo sin pantalla ----------------
+static void soak_finish();
+
+// Con --resistencia la salida la decide el veredicto, aunque corte --cuadros.
+static void headless_quit() {
+    g_output.finish();
+    double secs = seconds_now() - g_startTime;
+    printf("Sin pantalla: %ld cuadros dibujados (%.2f ms promedio), %lu escritos, %lu descartados, %lu tarde, %.1f s\n",
+           g_headlessFrames, g_headlessFrames ? g_headlessDrawTime * 1000.0 / g_headlessFrames : 0.0,
+           g_output.frames_written(), g_output.frames_dropped(), g_headlessLate, secs);
+    if (g_soak) soak_finish();
+    report_sources();
+    report_textures();
+    exit(0);
+}
+
+// Un cuadro por tick; el próximo se agenda contra el reloj para no acumular deriva.
+void headless_tick(int) {
+    double t0 = seconds_now();
+    g_output.begin_frame();
+    draw_scene();
+    g_output.end_frame();
+    g_headlessDrawTime += seconds_now() - t0;
+    g_headlessFrames++;
+    if (g_headlessMaxFrames > 0 && g_headlessFrames >= g_headlessMaxFrames) headless_quit();
+
+    double period = 1.0 / g_headlessFps;
+    g_headlessNext += period;
+    double now = seconds_now();
+    if (g_headlessNext < now) { // atrasado: se saltea en vez de encadenar cuadros
+        g_headlessLate++;
+        g_headlessNext = now + period;
+    }
+    glutTimerFunc((unsigned int)((g_headlessNext - now) * 1000.0), headless_tick, 0);
+}
+
+void headless_display() {
+    // la ventana está oculta: el dibujo lo hace headless_tick
+}
+
+// ---------------- Resistencia ----------------
+// Memoria residente del proceso en KB, de /proc/self/statm.
+static long rss_kb() {
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (!f) return 0;
+    long size = 0, resident = 0;
+    if (fscanf(f, "%ld %ld", &size, &resident) != 2) resident = 0;
+    fclose(f);
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// Creció sin cota si el mínimo del último cuarto supera al máximo del segundo cuarto
+// (el primero es calentamiento) por más de 'tol' relativo y 'slack' absoluto.
+static bool grew_unbounded(const std::vector<double> &v, double tol, double slack) {
+    size_t n = v.size();
+    double refMax = *std::max_element(v.begin() + n / 4, v.begin() + n / 2);
+    double lastMin = *std::min_element(v.begin() + n * 3 / 4, v.end());
+    return lastMin > refMax * (1.0 + tol) + slack;
+}
+
+// Devuelve false si algún recurso o el tiempo de captura siguió creciendo.
+static bool soak_verdict() {
+    if (g_soakSamples.size() < 8) {
+        fprintf(stderr, "Resistencia: muy pocas muestras (%zu) para evaluar\n", g_soakSamples.size());
+        return true;
+    }
+    std::vector<double> textures, mainTex, thumbTex, slots, byXid, windows, images, rss, capture;
+    for (auto &m : g_soakSamples) {
+        textures.push_back(m.textures);
+        mainTex.push_back(m.mainTextures);
+        thumbTex.push_back(m.thumbTextures);
+        slots.push_back(m.slots);
+        byXid.push_back(m.byXid);
+        windows.push_back(m.windows);
+        images.push_back(m.images);
+        rss.push_back(m.rssKB);
+        capture.push_back(m.captureP99);
+    }
+    struct { const char* name; const std::vector<double>* v; double tol, slack; } checks[] = {
+        { "texturas", &textures, 0.0, 8 },
+        { "tex_principal", &mainTex, 0.0, 2 },
+        { "tex_miniatura", &thumbTex, 0.0, 8 },
+        { "slots", &slots, 0.0, 8 },
+        { "por_xid", &byXid, 0.0, 8 },
+        { "ventanas", &windows, 0.0, 8 },
+        { "ximages", &images, 0.0, 4 },
+        { "rss_kb", &rss, 0.25, 32 * 1024 },
+        { "captura_p99_ms", &capture, 1.0, 5.0 },
+    };
+    bool ok = true;
+    for (auto &c : checks) {
+        if (!grew_unbounded(*c.v, c.tol, c.slack)) continue;
+        fprintf(stderr, "Resistencia: %s crece sin cota (%.1f -> %.1f)\n",
+                c.name, c.v->front(), c.v->back());
+        ok = false;
+    }
+    // toda textura viva tiene que colgar de una ventana del registro
+    const SoakSample &last = g_soakSamples.back();
+    if (last.textures != last.mainTextures + last.thumbTextures) {
+        fprintf(stderr, "Resistencia: %d texturas vivas sin ventana\n",
+                last.textures - last.mainTextures - last.thumbTextures);
+        ok = false;
+    }
+    return ok;
+}
+
+// La ventana propia (o su marco) nunca debe quedar en el registro.
+static bool own_window_registered() {
+    for (DisplaySource* s : g_sources) {
+        std::lock_guard<std::mutex> lock(s->m);
+        for (auto &slot : s->slots)
+            if (is_own_window(s, slot->xid)) return true;
+    }
+    return false;
+}
+
+static void soak_finish() {
+    if (g_soakOut) fclose(g_soakOut);
+    g_soakOut = nullptr;
+    bool ok = soak_verdict();
+    if (own_window_registered()) {
+        fprintf(stderr, "Resistencia: la ventana propia quedó en el registro\n");
+        ok = false;
+    }
+    const SoakSample &last = g_soakSamples.empty() ? SoakSample() : g_soakSamples.back();
+    printf("Resistencia: %zu muestras; al final %d texturas (%d principal, %d miniatura), %d slots, "
+           "%d por XID, %d ventanas, %ld XImages, %ld KB RSS: %s\n",
+           g_soakSamples.size(), last.textures, last.mainTextures, last.thumbTextures, last.slots,
+           last.byXid, last.windows, last.images, last.rssKB, ok ? "sin crecimiento" : "FALLA");
+    report_sources();
+    report_textures();
+    if (g_headless) g_output.finish();
+    exit(ok ? 0 : 3);
+}
+
+void soak_tick(int) {
+    SoakSample m = {};
+    m.t = seconds_now() - g_startTime;
+    m.textures = g_liveTextures;
+    for (auto &w : g_windows) {
+        if (w.tex) m.mainTextures++;
+        if (w.thumbTex) m.thumbTextures++;
+    }
+    m.windows = g_windows.size();
+    m.images = g_liveImages;
+    m.rssKB = rss_kb();
+
+    LatencyHistogram passes("captura");
+    for (DisplaySource* s : g_sources) {
+        std::lock_guard<std::mutex> lock(s->m);
+        passes.samples.insert(passes.samples.end(), s->passMs.begin(), s->passMs.end());
+        s->passMs.clear();
+        m.slots += s->slots.size();
+        m.byXid += s->byXidSize;
+    }
+    m.captureP50 = passes.percentile(50);
+    m.captureP99 = passes.percentile(99);
+    g_soakSamples.push_back(m);
+
+    if (g_soakOut) {
+        fprintf(g_soakOut, "%.1f %d %d %d %d %d %d %ld %ld %.3f %.3f\n", m.t, m.textures, m.mainTextures,
+                m.thumbTextures, m.slots, m.byXid, m.windows, m.images, m.rssKB, m.captureP50, m.captureP99);
+        fflush(g_soakOut);
+    }
+
+    if (m.t >= g_soakDuration) soak_finish();
+    glutTimerFunc(1000, soak_tick, 0);
+}
+
+static void start_soak() {
+    g_soakOut = fopen(g_soakFile, "w");
+    if (!g_soakOut) fprintf(stderr, "No se pudo escribir %s\n", g_soakFile);
+    else fprintf(g_soakOut, "# segundos texturas tex_principal tex_miniatura slots por_xid ventanas ximages rss_kb "
+                            "captura_p50_ms captura_p99_ms\n");
+    glutTimerFunc(1000, soak_tick, 0);
+}
+
 // ---------------- Eventos ----------------
 void toggle_fullscreen() {
     if (isFullscreen) { glutReshapeWindow(1024, 700); isFullscreen = false; }
@@ -273,47 +1144,85 @@ void toggle_fullscreen() {
 }
 
 void special_key(int key, int, int) {
-    if (key == GLUT_KEY_F4) toggle_fullscreen();
+    switch (key) {
+    case GLUT_KEY_F4: toggle_fullscreen(); break;
+    case GLUT_KEY_LEFT: scroll_strip(-GRID_ROWS); break;
+    case GLUT_KEY_RIGHT: scroll_strip(GRID_ROWS); break;
+    case GLUT_KEY_PAGE_UP: scroll_strip(-strip_capacity()); break;
+    case GLUT_KEY_PAGE_DOWN: scroll_strip(strip_capacity()); break;
+    case GLUT_KEY_HOME: scroll_strip(-(int)g_windows.size()); break;
+    case GLUT_KEY_END: scroll_strip((int)g_windows.size()); break;
+    }
 }
 
 void keyboard(unsigned char key, int, int) {
     if (key == 27) {
-        for (auto &w : g_windows)
-            if (w.tex) glDeleteTextures(1, &w.tex);
-
-        if (x_display) {
-            XCloseDisplay(x_display);
-            x_display = nullptr;
+        if (g_soak) {
+            report_switches();
+            soak_finish();
         }
+        report_textures();
+        for (auto &w : g_windows) {
+            delete_texture(w.tex);
+            delete_texture(w.thumbTex);
+        }
+
+        // Los hilos de captura pueden estar bloqueados en un display lento: no se
+        // esperan ni se cierran sus conexiones, el proceso termina igual.
+        report_sources();
+        report_switches();
 
         glutDestroyWindow(glutGetWindow());
         exit(0);
     }
 }
 
-void mouse_click(int button, int state, int mx, int my) {
-    if (button != GLUT_LEFT_BUTTON || state != GLUT_DOWN) return;
+// Índice de la miniatura bajo (mx, my), o -1.
+static int thumbnail_at(int mx, int my) {
     float fx = (2.0f * mx) / winW - 1.0f;
     float fy = 1.0f - (2.0f * my) / winH;
     float panelTopY = -1.0f + 2.0f * PANEL_RATIO;
+    if (fy >= panelTopY) return -1;
+
+    int total = g_windows.size();
+    int rows = GRID_ROWS;
+    int cols = strip_columns();
+    float thumbW = 2.0f / cols;
+    float thumbH = (2.0f * PANEL_RATIO) / rows;
 
-    if (fy < panelTopY) {
-        int total = g_windows.size();
-        int rows = GRID_ROWS;
-        int cols = (total + rows - 1) / rows;
-        float thumbW = 2.0f / cols;
-        float thumbH = (2.0f * PANEL_RATIO) / rows;
+    int col = (int)((fx + 1.0f) / thumbW);
+    int row = (int)((panelTopY - fy) / thumbH);
+    if (col < 0 || col >= cols || row < 0 || row >= rows) return -1;
+    int idx = g_stripFirst + row * cols + col;
+    return idx < total ? idx : -1;
+}
 
-        int col = (int)((fx + 1.0f) / thumbW);
-        int row = (int)((panelTopY - fy) / thumbH);
-        int idx = row * cols + col;
-        if (idx >= 0 && idx < total)
-            g_selectedIndex = idx;
+void mouse_click(int button, int state, int mx, int my) {
+    // rueda del mouse (freeglut la reporta como botones 3 y 4)
+    if ((button == 3 || button == 4) && state == GLUT_DOWN) {
+        scroll_strip(button == 3 ? -GRID_ROWS : GRID_ROWS);
+        return;
     }
+    if (button != GLUT_LEFT_BUTTON || state != GLUT_DOWN) return;
+    int idx = thumbnail_at(mx, my);
+    if (idx >= 0) select_window(idx);
+}
+
+// La miniatura bajo el puntero pasa al frente de la cola de captura de su display.
+void mouse_motion(int mx, int my) {
+    int idx = thumbnail_at(mx, my);
+    if (idx >= 0) g_hoverSlot = g_windows[idx].slot;
+    else g_hoverSlot.reset();
+}
+
+// Puntero fuera de la ventana: ya no hay miniatura bajo él.
+void mouse_entry(int state) {
+    if (state == GLUT_LEFT) g_hoverSlot.reset();
 }
 
 void reshape(int w, int h) {
     winW = w; winH = h;
+    clamp_strip();
     glViewport(0, 0, w, h);
     glMatrixMode(GL_PROJECTION);
     glLoadIdentity();
@@ -325,20 +1234,117 @@ void reshape(int w, int h) {
 // ---------------- main ----------------
 int main(int argc, char** argv) {
     XInitThreads();
-    x_display = XOpenDisplay(nullptr);
-    if (!x_display) {
-        fprintf(stderr, "No se pudo abrir X display\n");
+    XSetErrorHandler(x_error_handler);
+    XSetIOErrorHandler(x_io_error_handler);
+
+    glutInit(&argc, argv);
+
+    // opciones propias (glutInit ya quitó las suyas)
+    int threads = default_thread_count();
+    bool benchThreads = false;
+    std::vector<std::string> names;
+    const char* outDir = ".";
+    const char* rawPath = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--hilos") && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--bench-hilos")) {
+            benchThreads = true;
+        } else if (!strcmp(argv[i], "--precalentar") && i + 1 < argc) {
+            g_warmK = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--presupuesto-cpu") && i + 1 < argc) {
+            g_warmShare = atof(argv[++i]) / 100.0;
+        } else if (!strcmp(argv[i], "--sin-pantalla")) {
+            g_headless = true;
+        } else if (!strcmp(argv[i], "--salida") && i + 1 < argc) {
+            outDir = argv[++i];
+        } else if (!strcmp(argv[i], "--salida-cruda") && i + 1 < argc) {
+            rawPath = argv[++i];
+        } else if (!strcmp(argv[i], "--fps") && i + 1 < argc) {
+            g_headlessFps = atof(argv[++i]);
+            if (g_headlessFps <= 0) g_headlessFps = 1;
+        } else if (!strcmp(argv[i], "--tamano") && i + 1 < argc) {
+            if (sscanf(argv[++i], "%dx%d", &winW, &winH) != 2 || winW <= 0 || winH <= 0) {
+                fprintf(stderr, "Tamaño inválido: %s (se espera ANCHOxALTO)\n", argv[i]);
+                return 1;
+            }
+        } else if (!strcmp(argv[i], "--cuadros") && i + 1 < argc) {
+            g_headlessMaxFrames = atol(argv[++i]);
+        } else if (!strcmp(argv[i], "--resistencia")) {
+            g_soak = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') g_soakFile = argv[++i];
+        } else if (!strcmp(argv[i], "--duracion") && i + 1 < argc) {
+            g_soakDuration = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--pantallas") && i + 1 < argc) {
+            // lista separada por comas; se puede repetir
+            std::string list = argv[++i];
+            size_t pos = 0;
+            while (pos <= list.size()) {
+                size_t comma = list.find(',', pos);
+                if (comma == std::string::npos) comma = list.size();
+                if (comma > pos) names.push_back(list.substr(pos, comma - pos));
+                pos = comma + 1;
+            }
+        } else {
+            fprintf(stderr, "Opción desconocida: %s\nUso: %s [--pantallas :1,:2,...] [--hilos N] [--bench-hilos] [--precalentar K] [--presupuesto-cpu PCT]\n"
+                    "       [--sin-pantalla [--salida DIR | --salida-cruda ARCHIVO] [--fps N] [--tamano ANCHOxALTO] [--cuadros N]]\n"
+                    "       [--resistencia [archivo] [--duracion s]]\n",
+                    argv[i], argv[0]);
+            return 1;
+        }
+    }
+
+    if (names.empty()) {
+        DisplaySource* s = open_source(nullptr);
+        if (s) g_sources.push_back(s);
+    } else {
+        // un display que no responde al abrir se omite; los demás siguen
+        for (auto &n : names) {
+            DisplaySource* s = open_source(n.c_str());
+            if (s) g_sources.push_back(s);
+        }
+    }
+    if (g_sources.empty()) {
+        fprintf(stderr, "No se pudo abrir ningún X display\n");
         return 1;
     }
 
-    x_root = DefaultRootWindow(x_display);
-    enumerate_windows();
-    if (!g_windows.empty()) g_selectedIndex = 0;
+    if (benchThreads)
+        return benchmark_window_conversion(g_sources[0]->dpy, g_sources[0]->root, default_thread_count());
+
+    // Con varios displays el paralelismo lo dan sus hilos de captura; el pool de
+    // bandas no admite llamadas concurrentes y queda para el caso de un display.
+    if (g_sources.size() == 1) g_pool = new ThreadPool(threads);
+
+    g_sourceVersions.assign(g_sources.size(), 0);
+    g_startTime = seconds_now();
 
-    glutInit(&argc, argv);
     glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGBA);
+    if (g_headless) {
+        // la ventana GLUT solo aporta el contexto GL; nunca se muestra
+        glutInitWindowSize(64, 64);
+        glutCreateWindow("Gestor de Ventanas - Sin pantalla");
+        glutHideWindow();
+        start_capture_threads();
+        if (!g_output.init(winW, winH, outDir, rawPath)) return 1;
+        glMatrixMode(GL_PROJECTION);
+        glLoadIdentity();
+        glOrtho(-1, 1, -1, 1, -1, 1);
+        glMatrixMode(GL_MODELVIEW);
+        glLoadIdentity();
+        glEnable(GL_TEXTURE_2D);
+
+        glutDisplayFunc(headless_display);
+        g_headlessNext = seconds_now();
+        glutTimerFunc(0, headless_tick, 0);
+        if (g_soak) start_soak();
+        glutMainLoop();
+        headless_quit();
+    }
+
     glutInitWindowSize(winW, winH);
     glutCreateWindow("Gestor de Ventanas - Live");
+    start_capture_threads();
     glutSetOption(GLUT_ACTION_ON_WINDOW_CLOSE, GLUT_ACTION_GLUTMAINLOOP_RETURNS);
     glutFullScreen();
     isFullscreen = true;
@@ -348,9 +1354,16 @@ int main(int argc, char** argv) {
     glutKeyboardFunc(keyboard);
     glutSpecialFunc(special_key);
     glutMouseFunc(mouse_click);
+    glutPassiveMotionFunc(mouse_motion);
+    glutEntryFunc(mouse_entry);
 
     glClearColor(0,0,0,1);
     glEnable(GL_TEXTURE_2D);
+    if (g_soak) start_soak();
     glutMainLoop();
+    report_switches();
+    if (g_soak) soak_finish();
+    report_sources();
+    report_textures();
     return 0;
 }
@@ -2,11 +2,18 @@
 #include <X11/Xutil.h>
 #include <GL/gl.h>
 #include <GL/glut.h>
+#include <GL/glx.h>
 #include <vector>
 #include <string>
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include "conversion_pixeles.h"
+#include "cache_instantaneas.h"
+#include "sonda_latencia.h"
+#include "prediccion_cambios.h"
+#include "estado_ventanas.h"
 
 struct WindowInfo {
     Window xid;
@@ -14,17 +21,74 @@ struct WindowInfo {
     GLuint tex;
     int texW, texH;
     bool capturable;
+    double warmedAt;  // última captura de precalentamiento (seconds_now), 0 = fría
+    CaptureGate gate; // estado y geometría mantenidos por eventos
+    bool gone;        // destruida: se quita de la lista al final de process_events()
 };
 
 Display* x_display = nullptr;
 Window x_root = 0;
 std::vector<WindowInfo> g_windows;
 int g_selectedIndex = 0;
+Window g_ownWindow = 0;  // ventana GLUT propia; ni ella ni su marco se registran
+Window g_ownFrame = 0;
 
 int winW = 1280;
 int winH = 720;
 bool isFullscreen = true;
 
+unsigned long g_gatedCaptures = 0; // capturas evitadas por el estado de la ventana
+
+ThreadPool* g_pool = nullptr;    // conversión por bandas (--hilos N)
+UploadBuffer g_uploadBuffer;     // destino de la conversión, se reutiliza entre capturas
+Window g_uploadOwner = 0;        // ventana cuyo último frame en vivo está en g_uploadBuffer
+int g_uploadW = 0, g_uploadH = 0;
+
+// ---------------- Modo latencia (--latencia) ----------------
+// Decodifica el patrón de sonda_latencia en cada captura de la ventana seleccionada
+// y mide pintado→captura, pintado→subida y pintado→swap.
+bool g_latencyMode = false;
+const char* g_latencyFile = nullptr;
+double g_latencyDuration = 0.0;  // segundos, 0 = hasta ESC
+double g_latencyMaxP99 = 0.0;    // ms, 0 = sin umbral
+uint64_t g_latencyStart = 0;
+LatencyHistogram g_latCapture("captura");
+LatencyHistogram g_latUpload("subida");
+LatencyHistogram g_latSwap("swap");
+bool g_probePending = false;     // frame nuevo subido, falta medir el swap
+uint64_t g_probeTime = 0;
+uint32_t g_probeLastCounter = 0;
+bool g_probeSeen = false;
+size_t g_probeRepeated = 0, g_probeUnreadable = 0;
+
+// ---------------- Caché de instantáneas (--cache-mb) ----------------
+// Al cambiar de ventana se muestra su último frame comprimido mientras llega la captura en vivo.
+SnapshotCache* g_snapshots = nullptr;
+SnapshotCompressor* g_compressor = nullptr; // comprime fuera del hilo de GL
+UploadBuffer g_snapshotBuffer;      // destino de la descompresión
+bool g_skipCapture = false;         // este frame muestra la instantánea, se captura en el siguiente
+Window g_pendingStore = 0;          // su último frame sigue en g_uploadBuffer, falta encolarlo
+int g_pendingStoreW = 0, g_pendingStoreH = 0;
+bool g_switchPending = false;       // cambio de ventana sin primer pixel en pantalla
+bool g_switchLivePending = false;   // cambio de ventana sin primer frame en vivo
+bool g_switchFromCache = false;
+uint64_t g_switchStart = 0;
+LatencyHistogram g_switchCached("cache");
+LatencyHistogram g_switchCold("frio");
+LatencyHistogram g_switchLive("en vivo");
+LatencyHistogram* g_switchHist = nullptr; // histograma del cambio en curso
+
+// ---------------- Precalentamiento (--precalentar K) ----------------
+// Las K ventanas más probables después de la actual conservan su textura y se
+// recapturan de a una, a baja frecuencia y dentro del presupuesto de CPU.
+SwitchPredictor<Window> g_predictor;
+int g_warmK = 2;
+WarmBudget g_warmBudget(0.10);      // --presupuesto-cpu PCT
+const double WARM_REFRESH_S = 1.0;  // antigüedad máxima de una textura precalentada
+UploadBuffer g_warmBuffer;          // aparte: g_uploadBuffer puede tener una instantánea pendiente
+LatencyHistogram g_switchWarm("precal.");
+unsigned long g_warmHits = 0, g_warmMisses = 0;
+
 // ---------------- Manejo de errores X ----------------
 static int trapped_error_code = 0;
 int x_error_handler(Display*, XErrorEvent* error) {
@@ -68,8 +132,26 @@ static std::string get_window_title(Display* dpy, Window w) {
     return "[Sin título]";
 }
 
+static bool is_own_window(Window w) {
+    return w == g_ownWindow || (g_ownFrame && w == g_ownFrame);
+}
+
+static void add_window(Window w, const XWindowAttributes &attr) {
+    if (is_own_window(w)) return;
+    WindowInfo info{};
+    info.xid = w;
+    info.title = get_window_title(x_display, w);
+    info.tex = 0;
+    info.texW = info.texH = 0;
+    info.capturable = false;
+    gate_init(x_display, w, attr, info.gate);
+    g_windows.push_back(info);
+}
+
+// La raíz se suscribe antes de listar para no perder ventanas que aparezcan en el medio.
 void enumerate_windows() {
     g_windows.clear();
+    XSelectInput(x_display, x_root, SubstructureNotifyMask);
     Window root_return, parent_return;
     Window* children = nullptr;
     unsigned int nchildren = 0;
@@ -82,66 +164,96 @@ void enumerate_windows() {
     for (unsigned int i = 0; i < nchildren; ++i) {
         Window w = children[i];
         XWindowAttributes attr;
-        if (!XGetWindowAttributes(x_display, w, &attr)) continue;
-        if (attr.map_state != IsViewable) continue; // solo ventanas visibles
-
-        WindowInfo info{};
-        info.xid = w;
-        info.title = get_window_title(x_display, w);
-        info.tex = 0;
-        info.texW = info.texH = 0;
-        info.capturable = false;
-        g_windows.push_back(info);
+        // puede destruirse en cualquier momento: sin trampa, el BadWindow cerraría el gestor
+        start_xerror_trap();
+        bool added = false;
+        if (XGetWindowAttributes(x_display, w, &attr) && attr.map_state == IsViewable) { // solo visibles
+            add_window(w, attr);
+            added = !g_windows.empty() && g_windows.back().xid == w;
+        }
+        if (end_xerror_trap() && added) g_windows.pop_back();
     }
 
     if (children) XFree(children);
 }
 
-// ---------------- Captura segura ----------------
-static void ensure_texture(WindowInfo &info) {
-    XWindowAttributes wa;
-    if (!XGetWindowAttributes(x_display, info.xid, &wa)) {
-        info.capturable = false;
-        return;
-    }
-
-    info.capturable = (wa.width > 0 && wa.height > 0);
-    if (!info.capturable) return;
+// Las destruidas no cuentan: su XID puede reusarse antes de que se quiten.
+static WindowInfo* find_window(Window w) {
+    for (auto &info : g_windows)
+        if (info.xid == w && !info.gone) return &info;
+    return nullptr;
+}
 
-    start_xerror_trap();
-    XImage* img = XGetImage(x_display, info.xid, 0, 0, wa.width, wa.height, AllPlanes, ZPixmap);
-    bool failed = end_xerror_trap();
+// Suelta todo lo de una ventana destruida y la marca para quitarla; se quita recién
+// en remove_gone_windows() porque quien llama puede tener referencias a g_windows.
+static void forget_window(WindowInfo &info) {
+    if (info.tex) {
+        glDeleteTextures(1, &info.tex);
+        info.tex = 0;
+    }
+    g_compressor->forget(info.xid);
+    g_predictor.forget(info.xid);
+    if (g_pendingStore == info.xid) g_pendingStore = 0;
+    if (g_uploadOwner == info.xid) g_uploadOwner = 0; // el XID puede reusarse
+    info.gate = CaptureGate();
+    info.capturable = false;
+    info.warmedAt = 0.0;
+    info.gone = true;
+}
 
-    if (failed || !img) {
-        info.capturable = false;
-        return;
+// Quita las destruidas. Las teclas 1..9 pasan a las ventanas que quedan; si la
+// seleccionada se fue, queda la que ocupa su lugar (o la última).
+static void remove_gone_windows() {
+    int selected = g_selectedIndex;
+    bool lost = false;
+    for (int i = (int)g_windows.size() - 1; i >= 0; --i) {
+        if (!g_windows[i].gone) continue;
+        g_windows.erase(g_windows.begin() + i);
+        if (i < selected) selected--;
+        else if (i == selected) lost = true;
     }
+    if (selected >= (int)g_windows.size()) selected = (int)g_windows.size() - 1;
+    if (lost) g_skipCapture = false; // la nueva seleccionada se captura en vivo
+    g_selectedIndex = selected;
+}
 
-    int width = wa.width;
-    int height = wa.height;
-    unsigned char* pixels = new unsigned char[width * height * 3];
-
-    unsigned long rmask = img->red_mask;
-    unsigned long gmask = img->green_mask;
-    unsigned long bmask = img->blue_mask;
-    int rshift = 0; while (!((rmask >> rshift) & 1) && rshift < 32) rshift++;
-    int gshift = 0; while (!((gmask >> gshift) & 1) && gshift < 32) gshift++;
-    int bshift = 0; while (!((bmask >> bshift) & 1) && bshift < 32) bshift++;
-
-    for (int y = 0; y < height; ++y) {
-        int ty = height - 1 - y;
-        for (int x = 0; x < width; ++x) {
-            unsigned long p = XGetPixel(img, x, y);
-            unsigned char r = ((p & rmask) >> rshift) & 0xFF;
-            unsigned char g = ((p & gmask) >> gshift) & 0xFF;
-            unsigned char b = ((p & bmask) >> bshift) & 0xFF;
-            int idx = (ty * width + x) * 3;
-            pixels[idx] = r;
-            pixels[idx + 1] = g;
-            pixels[idx + 2] = b;
+// Atiende los eventos pendientes: ventanas nuevas, destruidas y cambios de estado.
+static void process_events() {
+    while (XPending(x_display)) {
+        XEvent ev;
+        XNextEvent(x_display, &ev);
+        Window w = gate_event_window(ev);
+        WindowInfo* info = find_window(w);
+
+        if (ev.type == MapNotify && ev.xmap.event == x_root && !info) {
+            XWindowAttributes attr;
+            start_xerror_trap();
+            if (XGetWindowAttributes(x_display, w, &attr)) add_window(w, attr);
+            end_xerror_trap(); // si se destruyó en el medio, llega su DestroyNotify
+        } else if (ev.type == DestroyNotify && ev.xdestroywindow.event == x_root) {
+            if (info) forget_window(*info);
+        } else if (ev.type == ReparentNotify && ev.xreparent.event == x_root && ev.xreparent.parent != x_root) {
+            info = find_window(ev.xreparent.window); // la enmarcó el gestor de ventanas
+            if (info) forget_window(*info);
+            if (ev.xreparent.window == g_ownWindow) {
+                g_ownFrame = ev.xreparent.parent;
+                if ((info = find_window(g_ownFrame))) forget_window(*info);
+            }
+        } else if (info && ev.type == PropertyNotify) {
+            // relee _NET_WM_STATE: la ventana pudo destruirse después del evento
+            start_xerror_trap();
+            gate_update(x_display, ev, info->gate);
+            if (end_xerror_trap() && (trapped_error_code == BadWindow || trapped_error_code == BadDrawable))
+                forget_window(*info);
+        } else if (info) {
+            gate_update(x_display, ev, info->gate);
         }
     }
+    remove_gone_windows();
+}
 
+// ---------------- Captura segura ----------------
+static void upload_texture(WindowInfo &info, const unsigned char* pixels, int width, int height) {
     if (info.tex == 0)
         glGenTextures(1, &info.tex);
 
@@ -154,11 +266,125 @@ static void ensure_texture(WindowInfo &info) {
 
     info.texW = width;
     info.texH = height;
+}
+
+// Captura la ventana entera; nullptr si no se puede (y queda marcada como no capturable).
+// Sin mapear, minimizada o tapada del todo no se captura y se sigue mostrando el último frame;
+// la geometría sale de ConfigureNotify, sin ida y vuelta previa al servidor.
+static XImage* grab_window(WindowInfo &info) {
+    if (!info.gate.can_capture()) {
+        g_gatedCaptures++;
+        return nullptr;
+    }
+
+    start_xerror_trap();
+    XImage* img = XGetImage(x_display, info.xid, 0, 0, info.gate.width, info.gate.height, AllPlanes, ZPixmap);
+    bool failed = end_xerror_trap();
+
+    if (failed || !img) {
+        if (img) XDestroyImage(img);
+        info.capturable = false;
+        // destruida antes de su DestroyNotify: se suelta ya para no reintentar cada frame
+        if (trapped_error_code == BadWindow || trapped_error_code == BadDrawable) forget_window(info);
+        return nullptr;
+    }
+    info.capturable = true;
+    return img;
+}
+
+static void ensure_texture(WindowInfo &info) {
+    XImage* img = grab_window(info);
+    uint64_t tCapture = probe_now_us();
+    if (!img) return;
+
+    int width = img->width;
+    int height = img->height;
+    g_uploadOwner = 0; // se pisa el frame anterior, sea de quien sea
+    unsigned char* pixels = g_uploadBuffer.reserve((size_t)width * height * 3);
+    if (!pixels) {
+        info.capturable = false;
+        XDestroyImage(img);
+        return;
+    }
+
+    // Conversión a RGB con flip vertical (ty = height - 1 - y), por bandas de filas
+    // en el pool de hilos cuando la ventana es grande.
+    convert_image_rgb(img, pixels, g_pool);
+    g_uploadOwner = info.xid;
+    g_uploadW = width;
+    g_uploadH = height;
+
+    bool newProbeFrame = false;
+    uint64_t probeTime = 0;
+    uint32_t probeCounter = 0;
+    if (g_latencyMode) {
+        if (!probe_decode(pixels, width, height, true, &probeTime, &probeCounter)) {
+            g_probeUnreadable++;
+        } else if (g_probeSeen && probeCounter == g_probeLastCounter) {
+            g_probeRepeated++;
+        } else {
+            newProbeFrame = true;
+            g_probeSeen = true;
+            g_probeLastCounter = probeCounter;
+            g_latCapture.add(probe_latency_ms(probeTime, tCapture));
+        }
+    }
+
+    upload_texture(info, pixels, width, height);
+
+    if (newProbeFrame) {
+        g_latUpload.add(probe_latency_ms(probeTime, probe_now_us()));
+        g_probeTime = probeTime;
+        g_probePending = true;
+    }
 
-    delete[] pixels;
     XDestroyImage(img);
 }
 
+// Captura una ventana no seleccionada y deja su textura lista para el cambio.
+static void warm_window(WindowInfo &info) {
+    XImage* img = grab_window(info);
+    if (!img) return;
+    unsigned char* pixels = g_warmBuffer.reserve((size_t)img->width * img->height * 3);
+    if (pixels) {
+        convert_image_rgb(img, pixels, g_pool);
+        upload_texture(info, pixels, img->width, img->height);
+        info.warmedAt = seconds_now();
+    }
+    XDestroyImage(img);
+}
+
+// Un paso por frame: suelta las texturas que dejaron de estar entre las K probables
+// y refresca la más vieja de las que siguen, si el presupuesto lo permite.
+static void prewarm_step() {
+    if (g_warmK <= 0) return;
+    Window current = g_selectedIndex >= 0 ? g_windows[g_selectedIndex].xid : x_root;
+    std::vector<Window> ids;
+    for (auto &w : g_windows) ids.push_back(w.xid);
+    std::vector<Window> top = g_predictor.top_k(current, ids, g_warmK);
+
+    WindowInfo* stalest = nullptr;
+    for (int i = 0; i < (int)g_windows.size(); ++i) {
+        WindowInfo &w = g_windows[i];
+        if (i == g_selectedIndex) continue;
+        if (std::find(top.begin(), top.end(), w.xid) == top.end()) {
+            if (w.tex) {
+                glDeleteTextures(1, &w.tex);
+                w.tex = 0;
+            }
+            w.warmedAt = 0.0;
+            continue;
+        }
+        if (!w.gate.can_capture()) continue; // conserva la textura, se refresca cuando se pueda
+        if (!stalest || w.warmedAt < stalest->warmedAt) stalest = &w;
+    }
+
+    double now = seconds_now();
+    if (!stalest || now - stalest->warmedAt < WARM_REFRESH_S || !g_warmBudget.allowed(now)) return;
+    warm_window(*stalest);
+    g_warmBudget.charge(now, seconds_now());
+}
+
 // ---------------- Enviar click seguro ----------------
 bool send_mouse_click(WindowInfo &win, int wx, int wy) {
     XEvent event;
@@ -190,19 +416,158 @@ bool send_mouse_click(WindowInfo &win, int wx, int wy) {
     return true;
 }
 
+// ---------------- Cambio de ventana ----------------
+static void store_pending_snapshot() {
+    if (!g_pendingStore) return;
+    g_compressor->queue(g_pendingStore, g_uploadBuffer.data, g_pendingStoreW, g_pendingStoreH);
+    g_pendingStore = 0;
+}
+
+static void select_window(int idx) {
+    if (idx == g_selectedIndex) return;
+    store_pending_snapshot(); // un cambio anterior que todavía no se guardó
+
+    Window from = g_selectedIndex >= 0 ? g_windows[g_selectedIndex].xid : x_root;
+    g_predictor.record(from, idx >= 0 ? g_windows[idx].xid : x_root);
+
+    if (g_selectedIndex >= 0 && g_selectedIndex < (int)g_windows.size()) {
+        WindowInfo &old = g_windows[g_selectedIndex];
+        // solo si g_uploadBuffer tiene su frame en vivo: si se mostró una instantánea o una
+        // textura precalentada y nunca se capturó, el buffer es de otra ventana
+        if (g_uploadOwner == old.xid) {
+            g_pendingStore = old.xid;
+            g_pendingStoreW = g_uploadW;
+            g_pendingStoreH = g_uploadH;
+        }
+        // la textura completa solo queda residente para la ventana seleccionada y,
+        // con precalentamiento, para las probables (prewarm_step suelta las demás)
+        if (g_warmK > 0 && old.tex) {
+            old.warmedAt = seconds_now();
+        } else if (old.tex) {
+            glDeleteTextures(1, &old.tex);
+            old.tex = 0;
+        }
+    }
+
+    g_selectedIndex = idx;
+    g_skipCapture = false;
+    g_switchFromCache = false;
+    g_switchHist = &g_switchCold;
+    g_switchPending = g_switchLivePending = true;
+    g_switchStart = probe_now_us();
+
+    if (idx >= 0) {
+        WindowInfo &sel = g_windows[idx];
+        if (sel.tex && sel.warmedAt > 0) {
+            // precalentada: la textura ya está, la captura en vivo sigue en el próximo frame
+            sel.warmedAt = 0.0;
+            g_skipCapture = true;
+            g_switchFromCache = true;
+            g_switchHist = &g_switchWarm;
+            g_warmHits++;
+        } else {
+            std::lock_guard<std::mutex> lock(g_compressor->lock);
+            const Snapshot* snap = g_snapshots->find(sel.xid);
+            size_t npixels = snap ? (size_t)snap->width * snap->height : 0;
+            unsigned char* rgb = snap ? g_snapshotBuffer.reserve(npixels * 3) : nullptr;
+            if (rgb && snapshot_decompress(snap->data, rgb, npixels)) {
+                upload_texture(sel, rgb, snap->width, snap->height);
+                sel.capturable = true;
+                g_skipCapture = true;
+                g_switchFromCache = true;
+                g_switchHist = &g_switchCached;
+            }
+        }
+        if (g_warmK > 0 && g_switchHist != &g_switchWarm) g_warmMisses++;
+    }
+
+    // sin instantánea la captura en vivo va a pisar g_uploadBuffer: guardar ya
+    if (!g_switchFromCache) store_pending_snapshot();
+}
+
+static void report_switches() {
+    if (g_switchCached.samples.empty() && g_switchCold.samples.empty() && g_switchWarm.samples.empty()) return;
+    std::lock_guard<std::mutex> lock(g_compressor->lock);
+    printf("Cambio de ventana hasta el primer pixel (caché: %zu instantáneas, %.1f MB):\n",
+           g_snapshots->count(), g_snapshots->bytes_used() / (1024.0 * 1024.0));
+    if (g_warmK > 0)
+        printf("Precalentamiento K=%d: %lu aciertos, %lu fallos, %lu capturas, %.1f ms de CPU\n",
+               g_warmK, g_warmHits, g_warmMisses, g_warmBudget.jobs, g_warmBudget.spent * 1000.0);
+    g_switchWarm.report(stdout);
+    g_switchCached.report(stdout);
+    g_switchCold.report(stdout);
+    g_switchLive.report(stdout);
+}
+
+// ---------------- Reporte de latencia ----------------
+// Imprime p50/p95/p99 y, si se pidió, escribe el histograma completo al archivo.
+// Devuelve false si se superó el umbral de p99 (para usar como compuerta).
+static bool report_latency() {
+    const LatencyHistogram* hists[] = { &g_latCapture, &g_latUpload, &g_latSwap };
+
+    printf("Latencia sonda→pantalla (%zu frames repetidos, %zu ilegibles):\n",
+           g_probeRepeated, g_probeUnreadable);
+    for (const LatencyHistogram* h : hists) h->report(stdout);
+
+    if (g_latencyFile) {
+        FILE* f = fopen(g_latencyFile, "w");
+        if (!f) {
+            fprintf(stderr, "No se pudo escribir %s\n", g_latencyFile);
+        } else {
+            fprintf(f, "repetidos %zu\nilegibles %zu\n", g_probeRepeated, g_probeUnreadable);
+            for (const LatencyHistogram* h : hists) h->report(f);
+            for (const LatencyHistogram* h : hists) h->report_buckets(f);
+            fclose(f);
+        }
+    }
+
+    if (g_latSwap.samples.empty()) {
+        fprintf(stderr, "No se decodificó ningún frame de la sonda\n");
+        return false;
+    }
+    if (g_latencyMaxP99 > 0 && g_latSwap.percentile(99) > g_latencyMaxP99) {
+        fprintf(stderr, "p99 de swap %.2fms supera el umbral de %.2fms\n",
+                g_latSwap.percentile(99), g_latencyMaxP99);
+        return false;
+    }
+    return true;
+}
+
+static void quit_manager() {
+    int code = 0;
+    if (g_latencyMode && !report_latency()) code = 2;
+    for (auto &w : g_windows) {
+        if (!is_own_window(w.xid)) continue;
+        fprintf(stderr, "La ventana propia quedó en el registro\n");
+        code = 4;
+    }
+    report_switches();
+    printf("Capturas evitadas por el estado de la ventana: %lu\n", g_gatedCaptures);
+
+    for (auto &w : g_windows)
+        if (w.tex) glDeleteTextures(1, &w.tex);
+    if (x_display) XCloseDisplay(x_display);
+    exit(code);
+}
+
 // ---------------- Dibujo ----------------
 void display() {
     glClearColor(0, 0, 0, 1);
     glClear(GL_COLOR_BUFFER_BIT);
     glEnable(GL_TEXTURE_2D);
+    process_events();
 
-    if (g_windows.empty()) {
+    // sin ventana seleccionada se sigue redibujando: los eventos se atienden acá
+    if (g_selectedIndex < 0 || g_selectedIndex >= (int)g_windows.size()) {
         glutSwapBuffers();
+        glutPostRedisplay();
         return;
     }
 
     WindowInfo &sel = g_windows[g_selectedIndex];
-    ensure_texture(sel);
+    bool live = !g_skipCapture;
+    if (live) ensure_texture(sel);
+    g_skipCapture = false;
     if (sel.capturable && sel.tex) {
         float winAspect = (float)winW / winH;
         float texAspect = (float)sel.texW / sel.texH;
@@ -220,6 +585,34 @@ void display() {
     }
 
     glutSwapBuffers();
+
+    if ((g_switchPending || g_switchLivePending) && sel.capturable && sel.tex) {
+        glFinish();
+        double ms = (probe_now_us() - g_switchStart) / 1000.0;
+        if (g_switchPending) {
+            g_switchHist->add(ms);
+            printf("Primer pixel en %.2f ms (%s)\n", ms, g_switchHist->name);
+            g_switchPending = false;
+        }
+        if (live && g_switchLivePending) {
+            g_switchLive.add(ms);
+            g_switchLivePending = false;
+        }
+    }
+    store_pending_snapshot();
+    prewarm_step();
+
+    if (g_latencyMode) {
+        if (g_probePending) {
+            glFinish(); // el swap se considera hecho cuando el GL terminó
+            g_latSwap.add(probe_latency_ms(g_probeTime, probe_now_us()));
+            g_probePending = false;
+        }
+        if (g_latencyDuration > 0 &&
+            (probe_now_us() - g_latencyStart) / 1e6 >= g_latencyDuration)
+            quit_manager();
+    }
+
     glutPostRedisplay();
 }
 
@@ -227,15 +620,12 @@ void display() {
 void keyboard(unsigned char key, int, int) {
     if (key == '0') {  // root window
         printf("Seleccionada pantalla completa (root window)\n");
-        g_selectedIndex = -1; // usaremos -1 para root
+        select_window(-1); // usaremos -1 para root
     } else if (key >= '1' && key - '1' < (int)g_windows.size()) {
-        g_selectedIndex = key - '1';
+        select_window(key - '1');
         printf("Mostrando ventana %d: %s\n", g_selectedIndex, g_windows[g_selectedIndex].title.c_str());
     } else if (key == 27) { // ESC
-        for (auto &w : g_windows)
-            if (w.tex) glDeleteTextures(1, &w.tex);
-        if (x_display) XCloseDisplay(x_display);
-        exit(0);
+        quit_manager();
     }
 }
 
@@ -305,10 +695,63 @@ int main(int argc, char** argv) {
     if (!g_windows.empty()) g_selectedIndex = 0;
 
     glutInit(&argc, argv);
+
+    // opciones propias (glutInit ya quitó las suyas)
+    int threads = default_thread_count();
+    bool benchThreads = false;
+    int cacheMB = 256;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--hilos") && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--bench-hilos")) {
+            benchThreads = true;
+        } else if (!strcmp(argv[i], "--cache-mb") && i + 1 < argc) {
+            cacheMB = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--precalentar") && i + 1 < argc) {
+            g_warmK = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--presupuesto-cpu") && i + 1 < argc) {
+            g_warmBudget = WarmBudget(atof(argv[++i]) / 100.0);
+        } else if (!strcmp(argv[i], "--latencia")) {
+            g_latencyMode = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') g_latencyFile = argv[++i];
+        } else if (!strcmp(argv[i], "--duracion") && i + 1 < argc) {
+            g_latencyDuration = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--umbral-p99") && i + 1 < argc) {
+            g_latencyMaxP99 = atof(argv[++i]);
+        } else {
+            fprintf(stderr, "Opción desconocida: %s\n"
+                    "Uso: %s [--hilos N] [--bench-hilos] [--cache-mb N] [--precalentar K] [--presupuesto-cpu PCT] [--latencia [archivo]] [--duracion s] [--umbral-p99 ms]\n",
+                    argv[i], argv[0]);
+            return 1;
+        }
+    }
+
+    if (benchThreads)
+        return benchmark_window_conversion(x_display, x_root, default_thread_count());
+    g_pool = new ThreadPool(threads);
+    g_snapshots = new SnapshotCache((size_t)cacheMB * 1024 * 1024);
+    g_compressor = new SnapshotCompressor(g_snapshots);
+
+    if (g_latencyMode) {
+        for (size_t i = 0; i < g_windows.size(); ++i)
+            if (g_windows[i].title == "Sonda de latencia") g_selectedIndex = (int)i;
+        printf("Modo latencia: midiendo ventana %d: %s\n", g_selectedIndex,
+               g_windows.empty() ? "-" : g_windows[g_selectedIndex].title.c_str());
+        g_latencyStart = probe_now_us();
+    }
+
     glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGBA);
+    if (g_latencyMode) {
+        // sin servidor compuesto, la sonda tiene que quedar sin tapar
+        winW = 640;
+        winH = 480;
+        glutInitWindowPosition(0, PROBE_HEIGHT * 8);
+    }
     glutInitWindowSize(winW, winH);
     glutCreateWindow("Ventana Visible X11 - Click Forward");
-    glutFullScreen();
+    g_ownWindow = glXGetCurrentDrawable();
+    if (g_latencyMode) isFullscreen = false;
+    else glutFullScreen();
 
     glutDisplayFunc(display);
     glutReshapeFunc(reshape);
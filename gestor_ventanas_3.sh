@@ -2,7 +2,7 @@
 
 n=gestor_ventanas_3
 rm ./$n
-g++ $n.cpp -o $n -lXcomposite -lXrender -lglut -lGL -lGLU -lX11 -lXext
+g++ $n.cpp -o $n -pthread -lXcomposite -lXrender -lglut -lGL -lGLU -lX11 -lXext
 if [[ -f ./$n ]];then
 	cp -vf ./$n /bin
 	$n
@@ -0,0 +1,24 @@
+#!/bin/sh
+# Mide la latencia sonda→captura→subida→swap de gestor_ventanas_3 bajo Xvfb.
+# Uso: ./latencia_xvfb.sh [segundos] [umbral_p99_ms]
+# Sale con código 2 si el p99 de swap supera el umbral.
+# Sale con código 4 si la ventana propia del gestor quedó en su lista.
+
+duracion=${1:-10}
+umbral=${2:-0}
+pantalla=:97
+
+Xvfb $pantalla -screen 0 1280x720x24 &
+pid_xvfb=$!
+sleep 1
+
+DISPLAY=$pantalla ./sonda_latencia &
+pid_sonda=$!
+sleep 0.5
+
+DISPLAY=$pantalla LIBGL_ALWAYS_SOFTWARE=1 ./gestor_ventanas_3 \
+	--latencia latencia.txt --duracion $duracion --umbral-p99 $umbral
+rc=$?
+
+kill $pid_sonda $pid_xvfb
+exit $rc
@@ -0,0 +1,137 @@
+#ifndef POOL_HILOS_H
+#define POOL_HILOS_H
+
+// Pool de hilos persistente con robo de trabajo para repartir bandas de filas.
+// Cada hilo tiene su propia cola de bandas (contiguas, para aprovechar caché);
+// cuando la vacía, roba bandas del final de las colas ajenas.
+// El hilo que llama a parallel_for() también trabaja como hilo 0.
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <functional>
+
+class ThreadPool {
+public:
+    explicit ThreadPool(int threads) : nthreads(threads < 1 ? 1 : threads), queues(new Queue[nthreads]) {
+        for (int i = 1; i < nthreads; ++i)
+            workers.emplace_back(&ThreadPool::worker_loop, this, i);
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            stop = true;
+        }
+        wake.notify_all();
+        for (auto &t : workers) t.join();
+    }
+
+    int size() const { return nthreads; }
+
+    // Ejecuta fn(banda) para cada banda en [0, nbands) y espera a que terminen todas.
+    void parallel_for(int nbands, const std::function<void(int)> &fn) {
+        if (nbands <= 0) return;
+        if (nthreads == 1 || nbands == 1) {
+            for (int b = 0; b < nbands; ++b) fn(b);
+            return;
+        }
+
+        // reparto inicial en bloques contiguos
+        for (int i = 0; i < nthreads; ++i) {
+            std::lock_guard<std::mutex> lock(queues[i].m);
+            int from = (int)((long)nbands * i / nthreads);
+            int to = (int)((long)nbands * (i + 1) / nthreads);
+            for (int b = from; b < to; ++b) queues[i].bands.push_back(b);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m);
+            job = &fn;
+            remaining = nbands;
+            ++generation;
+        }
+        wake.notify_all();
+
+        run_bands(0, fn);
+
+        std::unique_lock<std::mutex> lock(m);
+        done.wait(lock, [this] { return remaining == 0 && busy == 0; });
+        job = nullptr;
+    }
+
+private:
+    struct alignas(64) Queue {   // una línea de caché por cola: sin falso compartir
+        std::mutex m;
+        std::deque<int> bands;
+    };
+
+    bool pop_or_steal(int self, int &band) {
+        {
+            Queue &q = queues[self];
+            std::lock_guard<std::mutex> lock(q.m);
+            if (!q.bands.empty()) {
+                band = q.bands.front();
+                q.bands.pop_front();
+                return true;
+            }
+        }
+        for (int k = 1; k < nthreads; ++k) {
+            Queue &q = queues[(self + k) % nthreads];
+            std::lock_guard<std::mutex> lock(q.m);
+            if (!q.bands.empty()) {
+                band = q.bands.back();
+                q.bands.pop_back();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void run_bands(int self, const std::function<void(int)> &fn) {
+        int band;
+        while (pop_or_steal(self, band)) {
+            fn(band);
+            std::lock_guard<std::mutex> lock(m);
+            if (--remaining == 0) done.notify_all();
+        }
+    }
+
+    void worker_loop(int self) {
+        unsigned long seen = 0;
+        for (;;) {
+            const std::function<void(int)>* fn;
+            {
+                std::unique_lock<std::mutex> lock(m);
+                wake.wait(lock, [&] { return stop || (generation != seen && job); });
+                if (stop) return;
+                seen = generation;
+                fn = job;
+                ++busy;
+            }
+            run_bands(self, *fn);
+            {
+                std::lock_guard<std::mutex> lock(m);
+                if (--busy == 0) done.notify_all();
+            }
+        }
+    }
+
+    int nthreads;
+    std::unique_ptr<Queue[]> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex m;
+    std::condition_variable wake, done;
+    const std::function<void(int)>* job = nullptr;
+    unsigned long generation = 0;
+    int remaining = 0;
+    int busy = 0;
+    bool stop = false;
+};
+
+#endif
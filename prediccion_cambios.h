@@ -0,0 +1,80 @@
+#ifndef PREDICCION_CAMBIOS_H
+#define PREDICCION_CAMBIOS_H
+
+// Predicción de la próxima ventana para precalentarla antes del cambio.
+// El modelo combina la frecuencia de cada transición (actual -> siguiente) con
+// la recencia de uso: la frecuencia manda y la recencia desempata, así que sin
+// historia de transiciones queda el orden MRU.
+
+#include <map>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+template <typename Key>
+class SwitchPredictor {
+public:
+    void record(Key from, Key to) {
+        if (from == to) return;
+        transitions[std::make_pair(from, to)]++;
+        lastUse[from] = ++clock;
+        lastUse[to] = ++clock;
+    }
+
+    // Las hasta 'k' ventanas de 'candidates' más probables después de 'current'.
+    // Las que nunca se usaron no se proponen.
+    std::vector<Key> top_k(Key current, const std::vector<Key> &candidates, int k) const {
+        std::vector<std::pair<double, Key>> scored;
+        for (const Key &c : candidates) {
+            if (c == current) continue;
+            auto used = lastUse.find(c);
+            if (used == lastUse.end()) continue;
+            double score = 1.0 / (1.0 + (clock - used->second)); // recencia, en (0, 1]
+            auto t = transitions.find(std::make_pair(current, c));
+            if (t != transitions.end()) score += t->second;
+            scored.push_back(std::make_pair(score, c));
+        }
+        std::sort(scored.begin(), scored.end(),
+                  [](const std::pair<double, Key> &a, const std::pair<double, Key> &b) { return a.first > b.first; });
+
+        std::vector<Key> out;
+        for (size_t i = 0; i < scored.size() && (int)i < k; ++i) out.push_back(scored[i].second);
+        return out;
+    }
+
+    // Olvida una ventana que ya no existe.
+    void forget(Key key) {
+        lastUse.erase(key);
+        for (auto it = transitions.begin(); it != transitions.end();) {
+            if (it->first.first == key || it->first.second == key) it = transitions.erase(it);
+            else ++it;
+        }
+    }
+
+private:
+    std::map<std::pair<Key, Key>, unsigned long> transitions;
+    std::map<Key, unsigned long> lastUse;
+    unsigned long clock = 0;
+};
+
+// Presupuesto de CPU del precalentamiento: después de un trabajo de 'dt' segundos
+// el siguiente espera lo necesario para que el trabajo sea la fracción 'share' del tiempo.
+struct WarmBudget {
+    double share;
+    double nextAllowed = 0.0;
+    double spent = 0.0;         // segundos dedicados a precalentar
+    unsigned long jobs = 0;
+
+    explicit WarmBudget(double s) : share(s > 0 ? s : 0.01) {}
+
+    bool allowed(double now) const { return now >= nextAllowed; }
+
+    void charge(double start, double end) {
+        double dt = end - start;
+        spent += dt;
+        jobs++;
+        nextAllowed = end + dt * (1.0 / share - 1.0);
+    }
+};
+
+#endif
@@ -0,0 +1,31 @@
+#!/bin/sh
+# Prueba de resistencia de gestor_ventanas_2 bajo Xvfb: generador_ventanas crea,
+# redimensiona y destruye ventanas mientras el gestor dibuja sin pantalla y anota
+# texturas por rol, tamaño de los registros, XImages vivas, RSS y tiempo de captura en resistencia.txt.
+# Uso: ./resistencia_xvfb.sh [segundos] [operaciones_por_segundo] [max_ventanas]
+# Sale con código 3 si algún recurso o el tiempo de captura crece sin cota, o si la
+# ventana propia del gestor quedó en su registro.
+
+duracion=${1:-300}
+ritmo=${2:-200}
+maximo=${3:-50}
+pantalla=:95
+
+Xvfb $pantalla -screen 0 1280x720x24 &
+pid_xvfb=$!
+sleep 1
+
+DISPLAY=$pantalla ./generador_ventanas $ritmo $maximo &
+pid_gen=$!
+sleep 0.5
+
+DISPLAY=$pantalla LIBGL_ALWAYS_SOFTWARE=1 ./gestor_ventanas_2 \
+	--sin-pantalla --salida-cruda /dev/null --fps 10 \
+	--resistencia resistencia.txt --duracion $duracion
+rc=$?
+
+# el generador informa cuántas ventanas creó por minuto al recibir SIGTERM
+kill $pid_gen
+wait $pid_gen
+kill $pid_xvfb
+exit $rc
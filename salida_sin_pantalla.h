@@ -0,0 +1,195 @@
+#ifndef SALIDA_SIN_PANTALLA_H
+#define SALIDA_SIN_PANTALLA_H
+
+// Salida del modo sin pantalla: la vista compuesta se dibuja en un framebuffer
+// fuera de pantalla y se lee con un anillo de PBOs. El glReadPixels de cada cuadro
+// va a un PBO y vuelve al instante; ese PBO se mapea recién PBO_RING - 1 cuadros
+// después, cuando el GL ya terminó de llenarlo, así que la lectura no frena el dibujo.
+// Un hilo escritor vuelca los cuadros como secuencia PPM o como flujo RGB crudo.
+// Necesita GL_GLEXT_PROTOTYPES antes del primer include de GL (funciona con Mesa/llvmpipe).
+
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+const int PBO_RING = 3;
+const size_t MAX_PENDING_FRAMES = 4; // cuadros esperando al escritor; más se descartan
+
+class OffscreenOutput {
+public:
+    ~OffscreenOutput() { finish(); }
+
+    // 'dir' recibe cuadro_000000.ppm, ...; 'rawPath' (si no es nullptr) recibe RGB crudo
+    // de arriba hacia abajo, cuadro tras cuadro (sirve un FIFO).
+    bool init(int w, int h, const char* dir, const char* rawPath) {
+        width = w;
+        height = h;
+        frameBytes = (size_t)w * h * 4;
+
+        if (rawPath) {
+            raw = fopen(rawPath, "wb");
+            if (!raw) {
+                fprintf(stderr, "No se pudo abrir %s\n", rawPath);
+                return false;
+            }
+        } else {
+            outDir = dir ? dir : ".";
+        }
+
+        glGenFramebuffers(1, &fbo);
+        glGenRenderbuffers(1, &color);
+        glBindRenderbuffer(GL_RENDERBUFFER, color);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, w, h);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+        GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        if (status != GL_FRAMEBUFFER_COMPLETE) {
+            fprintf(stderr, "Framebuffer fuera de pantalla incompleto (0x%x)\n", status);
+            return false;
+        }
+
+        glGenBuffers(PBO_RING, pbo);
+        for (int i = 0; i < PBO_RING; ++i) {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo[i]);
+            glBufferData(GL_PIXEL_PACK_BUFFER, frameBytes, nullptr, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        writer = std::thread(&OffscreenOutput::writer_loop, this);
+        return true;
+    }
+
+    // Dibujar entre begin_frame() y end_frame() va al framebuffer fuera de pantalla.
+    void begin_frame() {
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glViewport(0, 0, width, height);
+    }
+
+    void end_frame() {
+        int slot = issued % PBO_RING;
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo[slot]);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        issued++;
+
+        if (issued >= PBO_RING) collect((issued - PBO_RING) % PBO_RING);
+    }
+
+    // Recoge los cuadros que quedan en el anillo y espera al escritor.
+    void finish() {
+        if (!writer.joinable()) return;
+        long first = issued > PBO_RING - 1 ? issued - (PBO_RING - 1) : 0;
+        for (long k = first; k < issued; ++k) collect(k % PBO_RING);
+        {
+            std::lock_guard<std::mutex> lock(m);
+            stop = true;
+        }
+        wake.notify_all();
+        writer.join();
+        if (raw) fclose(raw);
+        raw = nullptr;
+    }
+
+    unsigned long frames_written() const { return written; }
+    unsigned long frames_dropped() const { return dropped; }
+
+private:
+    void collect(int slot) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo[slot]);
+        const unsigned char* data = static_cast<const unsigned char*>(glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY));
+        if (data) {
+            std::unique_lock<std::mutex> lock(m);
+            if (pending.size() >= MAX_PENDING_FRAMES) {
+                dropped++; // el escritor no da abasto: no se bloquea el dibujo
+            } else {
+                std::vector<unsigned char> frame;
+                if (!spare.empty()) {
+                    frame.swap(spare.back());
+                    spare.pop_back();
+                }
+                lock.unlock();
+                frame.assign(data, data + frameBytes);
+                lock.lock();
+                pending.push_back(std::move(frame));
+                wake.notify_one();
+            }
+        }
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    void writer_loop() {
+        std::vector<unsigned char> rgb((size_t)width * height * 3);
+        for (;;) {
+            std::vector<unsigned char> frame;
+            {
+                std::unique_lock<std::mutex> lock(m);
+                wake.wait(lock, [this] { return stop || !pending.empty(); });
+                if (pending.empty()) return;
+                frame.swap(pending.front());
+                pending.pop_front();
+            }
+
+            // RGBA de abajo hacia arriba (GL) -> RGB de arriba hacia abajo
+            for (int y = 0; y < height; ++y) {
+                const unsigned char* src = frame.data() + (size_t)(height - 1 - y) * width * 4;
+                unsigned char* dst = rgb.data() + (size_t)y * width * 3;
+                for (int x = 0; x < width; ++x, src += 4, dst += 3) {
+                    dst[0] = src[0]; dst[1] = src[1]; dst[2] = src[2];
+                }
+            }
+            write_frame(rgb.data());
+
+            std::lock_guard<std::mutex> lock(m);
+            spare.push_back(std::move(frame));
+        }
+    }
+
+    void write_frame(const unsigned char* rgb) {
+        size_t bytes = (size_t)width * height * 3;
+        if (raw) {
+            if (fwrite(rgb, 1, bytes, raw) == bytes) written++;
+            fflush(raw);
+            return;
+        }
+        char path[4096];
+        snprintf(path, sizeof(path), "%s/cuadro_%06lu.ppm", outDir.c_str(), written);
+        FILE* f = fopen(path, "wb");
+        if (!f) {
+            fprintf(stderr, "No se pudo escribir %s\n", path);
+            return;
+        }
+        fprintf(f, "P6\n%d %d\n255\n", width, height);
+        if (fwrite(rgb, 1, bytes, f) == bytes) written++;
+        fclose(f);
+    }
+
+    int width = 0, height = 0;
+    size_t frameBytes = 0;
+    GLuint fbo = 0, color = 0;
+    GLuint pbo[PBO_RING] = {0};
+    long issued = 0;
+
+    std::string outDir;
+    FILE* raw = nullptr;
+    std::thread writer;
+    std::mutex m;
+    std::condition_variable wake;
+    std::deque<std::vector<unsigned char>> pending;  // protegido por m
+    std::vector<std::vector<unsigned char>> spare;   // protegido por m; buffers para reusar
+    bool stop = false;
+    unsigned long written = 0;   // solo el hilo escritor
+    unsigned long dropped = 0;
+};
+
+#endif
@@ -0,0 +1,24 @@
+#!/bin/sh
+# Corre gestor_ventanas_2 sin pantalla bajo Xvfb y escribe la vista compuesta como PPM.
+# Uso: ./sin_pantalla_xvfb.sh [cuadros] [fps] [directorio]
+
+cuadros=${1:-50}
+fps=${2:-10}
+salida=${3:-cuadros}
+pantalla=:96
+
+mkdir -p $salida
+Xvfb $pantalla -screen 0 1280x720x24 &
+pid_xvfb=$!
+sleep 1
+
+DISPLAY=$pantalla xterm &
+pid_xterm=$!
+sleep 0.5
+
+DISPLAY=$pantalla LIBGL_ALWAYS_SOFTWARE=1 ./gestor_ventanas_2 \
+	--sin-pantalla --salida $salida --fps $fps --cuadros $cuadros --tamano 1280x720
+rc=$?
+
+kill $pid_xterm $pid_xvfb
+exit $rc
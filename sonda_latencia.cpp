@@ -0,0 +1,67 @@
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include "sonda_latencia.h"
+
+// Ventana cliente para medir latencia: repinta continuamente el patrón
+// con la marca de tiempo actual y un contador creciente.
+// Uso: sonda_latencia [period_ms]
+
+int main(int argc, char** argv) {
+    int period_ms = argc > 1 ? atoi(argv[1]) : 5;
+    if (period_ms < 1) period_ms = 1;
+
+    Display* dpy = XOpenDisplay(nullptr);
+    if (!dpy) {
+        fprintf(stderr, "No se pudo abrir X display\n");
+        return 1;
+    }
+
+    int screen = DefaultScreen(dpy);
+    unsigned long black = BlackPixel(dpy, screen);
+    unsigned long white = WhitePixel(dpy, screen);
+    Window w = XCreateSimpleWindow(dpy, DefaultRootWindow(dpy), 0, 0,
+                                   PROBE_WIDTH, PROBE_HEIGHT * 4, 0, black, black);
+    XStoreName(dpy, w, "Sonda de latencia");
+
+    XSizeHints hints;
+    hints.flags = PPosition | PMinSize;
+    hints.x = hints.y = 0;
+    hints.min_width = PROBE_WIDTH;
+    hints.min_height = PROBE_HEIGHT;
+    XSetWMNormalHints(dpy, w, &hints);
+
+    XMapWindow(dpy, w);
+    XSync(dpy, False);
+
+    GC gc = XCreateGC(dpy, w, 0, nullptr);
+    uint32_t counter = 0;
+
+    for (;;) {
+        uint64_t t = probe_now_us();
+        uint64_t data = probe_encode(t, counter++);
+
+        XSetForeground(dpy, gc, white);
+        XFillRectangle(dpy, w, gc, 0, 0, PROBE_CELL, PROBE_HEIGHT);
+        XSetForeground(dpy, gc, black);
+        XFillRectangle(dpy, w, gc, PROBE_CELL, 0, PROBE_CELL, PROBE_HEIGHT);
+        for (int b = 0; b < PROBE_BITS; ++b) {
+            XSetForeground(dpy, gc, ((data >> b) & 1) ? white : black);
+            XFillRectangle(dpy, w, gc, (2 + b) * PROBE_CELL, 0, PROBE_CELL, PROBE_HEIGHT);
+        }
+        XFlush(dpy);
+
+        // descartar eventos (Expose, etc.): se repinta igualmente en cada ciclo
+        while (XPending(dpy)) {
+            XEvent ev;
+            XNextEvent(dpy, &ev);
+        }
+        usleep(period_ms * 1000);
+    }
+
+    XFreeGC(dpy, gc);
+    XCloseDisplay(dpy);
+    return 0;
+}
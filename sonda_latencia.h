@@ -0,0 +1,109 @@
+#ifndef SONDA_LATENCIA_H
+#define SONDA_LATENCIA_H
+
+// Patrón compartido entre la ventana sonda (sonda_latencia.cpp) y el gestor.
+// La sonda pinta en su esquina superior izquierda una fila de celdas blanco/negro:
+// dos marcas de sincronía (blanco, negro) y 64 bits de datos =
+// 40 bits de marca de tiempo (µs, CLOCK_MONOTONIC) + 16 bits de contador + 8 bits de suma.
+
+#include <stdint.h>
+#include <time.h>
+#include <stdio.h>
+#include <vector>
+#include <algorithm>
+
+const int PROBE_CELL = 8;                       // lado de cada celda en píxeles
+const int PROBE_BITS = 64;
+const int PROBE_CELLS = 2 + PROBE_BITS;
+const int PROBE_WIDTH = PROBE_CELLS * PROBE_CELL;
+const int PROBE_HEIGHT = PROBE_CELL;
+const uint64_t PROBE_TIME_MASK = (1ULL << 40) - 1;
+
+static inline uint64_t probe_now_us() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static inline uint8_t probe_checksum(uint64_t data) {
+    uint8_t s = 0x5A;
+    for (int i = 0; i < 7; ++i) s ^= (uint8_t)(data >> (8 * i));
+    return s;
+}
+
+static inline uint64_t probe_encode(uint64_t t_us, uint32_t counter) {
+    uint64_t data = (t_us & PROBE_TIME_MASK) | ((uint64_t)(counter & 0xFFFF) << 40);
+    return data | ((uint64_t)probe_checksum(data) << 56);
+}
+
+// Lee el patrón desde un buffer RGB de 'width' x 'height' (3 bytes por píxel).
+// 'flipped' indica que las filas están volteadas (como en la textura: fila 0 abajo).
+static inline bool probe_decode(const unsigned char* rgb, int width, int height, bool flipped,
+                                uint64_t* t_us, uint32_t* counter) {
+    if (width < PROBE_WIDTH || height < PROBE_HEIGHT) return false;
+    int y = PROBE_CELL / 2;
+    if (flipped) y = height - 1 - y;
+
+    uint64_t data = 0;
+    for (int c = 0; c < PROBE_CELLS; ++c) {
+        const unsigned char* p = rgb + ((size_t)y * width + c * PROBE_CELL + PROBE_CELL / 2) * 3;
+        bool white = (p[0] + p[1] + p[2]) > 3 * 128;
+        if (c == 0) { if (!white) return false; continue; }
+        if (c == 1) { if (white) return false; continue; }
+        if (white) data |= 1ULL << (c - 2);
+    }
+
+    if ((uint8_t)(data >> 56) != probe_checksum(data & ((1ULL << 56) - 1))) return false;
+    *t_us = data & PROBE_TIME_MASK;
+    *counter = (uint32_t)((data >> 40) & 0xFFFF);
+    return true;
+}
+
+// Latencia en ms entre la marca de tiempo de la sonda (40 bits) y 'now_us'.
+static inline double probe_latency_ms(uint64_t t_us, uint64_t now_us) {
+    return (double)((now_us - t_us) & PROBE_TIME_MASK) / 1000.0;
+}
+
+// ---------------- Histograma de latencias ----------------
+struct LatencyHistogram {
+    const char* name;
+    std::vector<double> samples; // ms
+
+    explicit LatencyHistogram(const char* n) : name(n) {}
+
+    void add(double ms) { samples.push_back(ms); }
+
+    double percentile(double p) const {
+        if (samples.empty()) return 0.0;
+        std::vector<double> v(samples);
+        size_t k = (size_t)(p / 100.0 * (v.size() - 1) + 0.5);
+        std::nth_element(v.begin(), v.begin() + k, v.end());
+        return v[k];
+    }
+
+    void report(FILE* f) const {
+        fprintf(f, "%-8s n=%zu p50=%.2fms p95=%.2fms p99=%.2fms\n", name, samples.size(),
+                percentile(50), percentile(95), percentile(99));
+    }
+
+    // Cubetas logarítmicas: [0,0.25), [0.25,0.5), ... , [256,inf) ms
+    void report_buckets(FILE* f) const {
+        const int NBUCKETS = 12;
+        size_t buckets[NBUCKETS] = {0};
+        for (double ms : samples) {
+            int b = 0;
+            double limit = 0.25;
+            while (b < NBUCKETS - 1 && ms >= limit) { ++b; limit *= 2; }
+            buckets[b]++;
+        }
+        double from = 0.0, to = 0.25;
+        for (int b = 0; b < NBUCKETS; ++b) {
+            if (b == NBUCKETS - 1) fprintf(f, "%s [%g, inf) ms: %zu\n", name, from, buckets[b]);
+            else fprintf(f, "%s [%g, %g) ms: %zu\n", name, from, to, buckets[b]);
+            from = to;
+            to *= 2;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,5 @@
+#!/bin/sh
+
+n=sonda_latencia
+rm ./$n
+g++ $n.cpp -o $n -lX11